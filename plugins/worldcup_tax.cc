@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <string>
+
+#include "../worldcup_plugin.h"
+
+// Przykładowa wtyczka: "Urząd skarbowy" pobiera od przechodzącego gracza
+// podany w konfiguracji procent jego pieniędzy (domyślnie 10). Pole nie ma
+// stanu, więc partie torów obsługuje jedną pętlą po tablicy stanów kont.
+class TaxOffice : public FieldPlugin {
+private:
+    unsigned int percent = 10;
+
+    static unsigned int tax(unsigned int money, unsigned int percent) {
+        return static_cast<unsigned int>(static_cast<unsigned long long>(money) * percent / 100);
+    }
+
+public:
+    explicit TaxOffice(const std::string &argument) {
+        if (!argument.empty()) {
+            percent = std::min(std::stoul(argument), 100ul);
+        }
+    }
+
+    [[nodiscard]] std::string name() const override {
+        return "Urząd skarbowy";
+    }
+
+    void onPlayerPass(FieldPlayer &player) override {
+        player.subtractMoney(tax(player.money(), percent));
+    }
+
+    // Podatek nigdy nie przekracza stanu konta, więc nikt tu nie bankrutuje.
+    void onPlayersPass(const FieldLanes &lanes) override {
+        for (std::size_t lane = 0; lane < lanes.count; lane++) {
+            lanes.money[lane] -= tax(lanes.money[lane], percent);
+        }
+    }
+};
+
+WORLDCUP_FIELD_PLUGIN(TaxOffice)
@@ -0,0 +1,94 @@
+import math
+import unittest
+
+import worldcup
+
+
+class SimulateTest(unittest.TestCase):
+    def test_threads_do_not_change_results(self):
+        players = ['Ala', 'Bob', 'Cyryl']
+        single = worldcup.simulate(players, 500, rounds=60, seed=7, threads=1)
+        for threads in (2, 4, 7):
+            multi = worldcup.simulate(players, 500, rounds=60, seed=7, threads=threads)
+            for a, b in zip(single, multi):
+                self.assertEqual(memoryview(a).tobytes(), memoryview(b).tobytes())
+
+    def test_arrays_are_zero_copy_views(self):
+        winners, rounds, balances = worldcup.simulate(['a', 'b'], 100, seed=1)
+        for array in (winners, rounds, balances):
+            view = memoryview(array)
+            self.assertIs(view.obj, array)
+            self.assertTrue(view.readonly)
+            self.assertEqual(len(array), 100)
+        self.assertEqual(memoryview(balances).shape, (100, 2))
+        self.assertEqual(memoryview(winners).format, 'i')
+        # Drugi widok wskazuje tę samą pamięć, a tablica żyje dłużej niż widok.
+        first = memoryview(balances)
+        second = memoryview(balances)
+        self.assertEqual(first.tolist(), second.tolist())
+        with self.assertRaises(TypeError):
+            memoryview(rounds)[0] = 1
+
+    def test_custom_dice(self):
+        _, rounds, _ = worldcup.simulate(['a', 'b'], 10, rounds=5, dice=[[1, 1], [0, 1]])
+        self.assertTrue(all(1 <= r <= 5 for r in memoryview(rounds).tolist()))
+
+    def test_rules(self):
+        standard = worldcup.simulate(['a', 'b'], 50, seed=3)
+        three = worldcup.simulate(['a', 'b'], 50, seed=3, rules='threeDice')
+        self.assertNotEqual(memoryview(standard[2]).tobytes(), memoryview(three[2]).tobytes())
+        with self.assertRaises(ValueError):
+            worldcup.simulate(['a', 'b'], 1, rules='threeDice', dice=[[1], [1]])
+        with self.assertRaises(ValueError):
+            worldcup.simulate(['a', 'b'], 1, rules='chess')
+
+    def test_invalid_weights(self):
+        for weights in ([-1, 1], [math.nan, 1], [math.inf], [0, 0], []):
+            with self.subTest(weights=weights), self.assertRaises(ValueError):
+                worldcup.simulate(['a', 'b'], 1, dice=[weights, [1]])
+
+    def test_invalid_players(self):
+        with self.assertRaises(ValueError):
+            worldcup.simulate(['a'], 1)
+
+
+class RandomDieTest(unittest.TestCase):
+    def test_seeded_rolls(self):
+        die = worldcup.RandomDie([0, 0, 1])
+        self.assertEqual({die.roll() for _ in range(20)}, {3})
+
+    def test_invalid_weights(self):
+        for weights in ([-0.5, 1], [math.nan], [0, 0, 0], []):
+            with self.subTest(weights=weights), self.assertRaises(ValueError):
+                worldcup.RandomDie(weights)
+
+    def test_uninitialised_die(self):
+        die = worldcup.RandomDie.__new__(worldcup.RandomDie)
+        with self.assertRaises(RuntimeError):
+            die.roll()
+        with self.assertRaises(RuntimeError):
+            worldcup.WorldCup2022().add_die(die)
+
+
+class WorldCup2022Test(unittest.TestCase):
+    def test_play(self):
+        game = worldcup.WorldCup2022()
+        game.add_die(worldcup.RandomDie([1] * 6, seed=3))
+        game.add_die(worldcup.RandomDie([1] * 6, seed=4))
+        game.add_player('a')
+        game.add_player('b')
+        winner, rounds, balances = game.play(30)
+        self.assertIn(winner, (-1, 0, 1))
+        self.assertLessEqual(rounds, 30)
+        self.assertEqual(len(balances), 2)
+
+    def test_play_without_dice(self):
+        game = worldcup.WorldCup2022()
+        game.add_player('a')
+        game.add_player('b')
+        with self.assertRaises(ValueError):
+            game.play(10)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,506 @@
+// Moduł Pythona "worldcup" udostępniający silnik WorldCup2022.
+//
+// Wyniki serii gier są zwracane jako tablice implementujące protokół bufora,
+// które wskazują bezpośrednio na pamięć silnika, więc numpy.asarray() nie
+// kopiuje danych i nie powstaje żaden obiekt Pythona na wiersz. Na czas
+// symulacji zwalniany jest GIL. Silnik i kostki rozgrywanej wtedy gry są
+// oznaczone jako zajęte (flagi zmieniane tylko pod GIL-em), a próba użycia
+// ich z innego wątku kończy się RuntimeError zamiast wyścigu.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../worldcup_simulation.h"
+
+namespace {
+
+    // Wyniki serii gier; pamięć jest wspólna dla wszystkich widoków tablic.
+    struct BatchResults {
+        std::size_t games = 0;
+        std::size_t players = 0;
+        std::vector<std::int32_t> winners;
+        std::vector<std::uint32_t> rounds;
+        std::vector<std::uint32_t> balances;
+    };
+
+    struct ArrayObject {
+        PyObject_HEAD
+        std::shared_ptr<BatchResults> owner;
+        void *data;
+        const char *format;
+        Py_ssize_t itemSize;
+        int dimensions;
+        Py_ssize_t shape[2];
+        Py_ssize_t strides[2];
+    };
+
+    struct DieObject {
+        PyObject_HEAD
+        std::shared_ptr<RandomDie> die;
+        // Kostka należy do gry rozgrywanej właśnie bez GIL-a.
+        bool busy;
+    };
+
+    struct GameObject {
+        PyObject_HEAD
+        WorldCup2022 *engine;
+        std::vector<std::string> *players;
+        // Dodane kostki (z referencjami), żeby oznaczać je jako zajęte.
+        std::vector<PyObject *> *dice;
+        bool busy;
+    };
+
+    int arrayGetBuffer(PyObject *self, Py_buffer *view, int flags) {
+        auto *array = reinterpret_cast<ArrayObject *>(self);
+        if (flags & PyBUF_WRITABLE) {
+            PyErr_SetString(PyExc_BufferError, "worldcup arrays are read-only");
+            return -1;
+        }
+        view->obj = Py_NewRef(self);
+        view->buf = array->data;
+        view->itemsize = array->itemSize;
+        view->len = array->itemSize * array->shape[0] * (array->dimensions == 2 ? array->shape[1] : 1);
+        view->readonly = 1;
+        view->ndim = array->dimensions;
+        view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>(array->format) : nullptr;
+        view->shape = (flags & PyBUF_ND) == PyBUF_ND ? array->shape : nullptr;
+        view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? array->strides : nullptr;
+        view->suboffsets = nullptr;
+        view->internal = nullptr;
+        return 0;
+    }
+
+    // Typy są typami na stercie (PyType_FromSpec), więc obiekty trzymają
+    // referencję do swojego typu.
+    void release(PyObject *self) {
+        PyTypeObject *type = Py_TYPE(self);
+        type->tp_free(self);
+        Py_DECREF(type);
+    }
+
+    void arrayDealloc(PyObject *self) {
+        reinterpret_cast<ArrayObject *>(self)->owner.~shared_ptr();
+        release(self);
+    }
+
+    Py_ssize_t arrayLength(PyObject *self) {
+        return reinterpret_cast<ArrayObject *>(self)->shape[0];
+    }
+
+    PyType_Slot arraySlots[] = {
+        {Py_bf_getbuffer, reinterpret_cast<void *>(arrayGetBuffer)},
+        {Py_sq_length, reinterpret_cast<void *>(arrayLength)},
+        {Py_tp_dealloc, reinterpret_cast<void *>(arrayDealloc)},
+        {Py_tp_doc, const_cast<char *>("Read-only view of engine results (buffer protocol).")},
+        {0, nullptr}
+    };
+
+    PyType_Spec arraySpec = {"worldcup.Array", sizeof(ArrayObject), 0, Py_TPFLAGS_DEFAULT, arraySlots};
+
+    PyTypeObject *ArrayType = nullptr;
+
+    template <typename T>
+    PyObject *makeArray(const std::shared_ptr<BatchResults> &owner, std::vector<T> &values, const char *format,
+                        std::size_t rows, std::size_t columns) {
+        auto *array = reinterpret_cast<ArrayObject *>(ArrayType->tp_alloc(ArrayType, 0));
+        if (array == nullptr) {
+            return nullptr;
+        }
+        new (&array->owner) std::shared_ptr<BatchResults>(owner);
+        array->data = values.data();
+        array->format = format;
+        array->itemSize = sizeof(T);
+        array->dimensions = columns == 0 ? 1 : 2;
+        array->shape[0] = static_cast<Py_ssize_t>(rows);
+        array->shape[1] = static_cast<Py_ssize_t>(columns);
+        array->strides[0] = static_cast<Py_ssize_t>(sizeof(T) * (columns == 0 ? 1 : columns));
+        array->strides[1] = sizeof(T);
+        return reinterpret_cast<PyObject *>(array);
+    }
+
+    bool toStrings(PyObject *sequence, std::vector<std::string> &out) {
+        PyObject *items = PySequence_Fast(sequence, "players must be a sequence of str");
+        if (items == nullptr) {
+            return false;
+        }
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(items); i++) {
+            const char *name = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(items, i));
+            if (name == nullptr) {
+                Py_DECREF(items);
+                return false;
+            }
+            out.emplace_back(name);
+        }
+        Py_DECREF(items);
+        return true;
+    }
+
+    bool toWeights(PyObject *sequence, std::vector<double> &out) {
+        PyObject *items = PySequence_Fast(sequence, "die weights must be a sequence of numbers");
+        if (items == nullptr) {
+            return false;
+        }
+        out.assign(1, 0.0);
+        double total = 0.0;
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(items); i++) {
+            double weight = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(items, i));
+            if (weight == -1.0 && PyErr_Occurred()) {
+                Py_DECREF(items);
+                return false;
+            }
+            if (!std::isfinite(weight) || weight < 0.0) {
+                Py_DECREF(items);
+                PyErr_SetString(PyExc_ValueError, "die weights must be finite and non-negative");
+                return false;
+            }
+            out.push_back(weight);
+            total += weight;
+        }
+        Py_DECREF(items);
+        if (!(total > 0.0) || !std::isfinite(total)) {
+            PyErr_SetString(PyExc_ValueError, "die weights must have a positive finite sum");
+            return false;
+        }
+        return true;
+    }
+
+    // Kostka bez wywołanego __init__ nie ma silnika kostki.
+    bool checkDie(DieObject *die) {
+        if (die->die == nullptr) {
+            PyErr_SetString(PyExc_RuntimeError, "RandomDie.__init__ was not called");
+            return false;
+        }
+        if (die->busy) {
+            PyErr_SetString(PyExc_RuntimeError, "die is in use by a game being played");
+            return false;
+        }
+        return true;
+    }
+
+    bool checkGame(GameObject *game) {
+        if (game->busy) {
+            PyErr_SetString(PyExc_RuntimeError, "game is being played in another thread");
+            return false;
+        }
+        return true;
+    }
+
+    // RandomDie(weights, seed=0): wagi ścian od 1 oczka.
+    int dieInit(PyObject *self, PyObject *args, PyObject *kwargs) {
+        static const char *keywords[] = {"weights", "seed", nullptr};
+        PyObject *weights = nullptr;
+        unsigned long long seed = 0;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|K", const_cast<char **>(keywords), &weights, &seed)) {
+            return -1;
+        }
+        auto *die = reinterpret_cast<DieObject *>(self);
+        if (die->busy) {
+            PyErr_SetString(PyExc_RuntimeError, "die is in use by a game being played");
+            return -1;
+        }
+        std::vector<double> values;
+        if (!toWeights(weights, values)) {
+            return -1;
+        }
+        die->die = std::make_shared<RandomDie>(values, seed);
+        return 0;
+    }
+
+    PyObject *dieNew(PyTypeObject *type, PyObject *, PyObject *) {
+        PyObject *self = type->tp_alloc(type, 0);
+        if (self != nullptr) {
+            new (&reinterpret_cast<DieObject *>(self)->die) std::shared_ptr<RandomDie>();
+            reinterpret_cast<DieObject *>(self)->busy = false;
+        }
+        return self;
+    }
+
+    void dieDealloc(PyObject *self) {
+        reinterpret_cast<DieObject *>(self)->die.~shared_ptr();
+        release(self);
+    }
+
+    PyObject *dieRoll(PyObject *self, PyObject *) {
+        auto *die = reinterpret_cast<DieObject *>(self);
+        if (!checkDie(die)) {
+            return nullptr;
+        }
+        return PyLong_FromLong(die->die->roll());
+    }
+
+    PyMethodDef dieMethods[] = {
+        {"roll", dieRoll, METH_NOARGS, "Roll the die once."},
+        {nullptr, nullptr, 0, nullptr}
+    };
+
+    PyType_Slot dieSlots[] = {
+        {Py_tp_new, reinterpret_cast<void *>(dieNew)},
+        {Py_tp_init, reinterpret_cast<void *>(dieInit)},
+        {Py_tp_dealloc, reinterpret_cast<void *>(dieDealloc)},
+        {Py_tp_methods, dieMethods},
+        {Py_tp_doc, const_cast<char *>("RandomDie(weights, seed=0): die with given face weights starting at 1.")},
+        {0, nullptr}
+    };
+
+    PyType_Spec dieSpec = {"worldcup.RandomDie", sizeof(DieObject), 0, Py_TPFLAGS_DEFAULT, dieSlots};
+
+    PyTypeObject *DieType = nullptr;
+
+    PyObject *gameNew(PyTypeObject *type, PyObject *, PyObject *) {
+        PyObject *self = type->tp_alloc(type, 0);
+        if (self != nullptr) {
+            auto *game = reinterpret_cast<GameObject *>(self);
+            game->engine = new WorldCup2022();
+            game->players = new std::vector<std::string>();
+            game->dice = new std::vector<PyObject *>();
+            game->busy = false;
+        }
+        return self;
+    }
+
+    void gameDealloc(PyObject *self) {
+        auto *game = reinterpret_cast<GameObject *>(self);
+        delete game->engine;
+        delete game->players;
+        for (PyObject *die : *game->dice) {
+            Py_DECREF(die);
+        }
+        delete game->dice;
+        release(self);
+    }
+
+    PyObject *gameAddDie(PyObject *self, PyObject *die) {
+        if (!PyObject_TypeCheck(die, DieType)) {
+            PyErr_SetString(PyExc_TypeError, "expected worldcup.RandomDie");
+            return nullptr;
+        }
+        auto *game = reinterpret_cast<GameObject *>(self);
+        if (!checkGame(game) || !checkDie(reinterpret_cast<DieObject *>(die))) {
+            return nullptr;
+        }
+        game->engine->addDie(reinterpret_cast<DieObject *>(die)->die);
+        game->dice->push_back(Py_NewRef(die));
+        Py_RETURN_NONE;
+    }
+
+    PyObject *gameAddPlayer(PyObject *self, PyObject *name) {
+        const char *text = PyUnicode_AsUTF8(name);
+        if (text == nullptr) {
+            return nullptr;
+        }
+        auto *game = reinterpret_cast<GameObject *>(self);
+        if (!checkGame(game)) {
+            return nullptr;
+        }
+        game->players->emplace_back(text);
+        Py_RETURN_NONE;
+    }
+
+    // play(rounds) -> (winner, rounds, balances)
+    PyObject *gamePlay(PyObject *self, PyObject *args) {
+        unsigned int rounds;
+        if (!PyArg_ParseTuple(args, "I", &rounds)) {
+            return nullptr;
+        }
+        auto *game = reinterpret_cast<GameObject *>(self);
+        if (!checkGame(game)) {
+            return nullptr;
+        }
+        for (PyObject *die : *game->dice) {
+            if (!checkDie(reinterpret_cast<DieObject *>(die))) {
+                return nullptr;
+            }
+        }
+        auto markBusy = [game](bool busy) {
+            game->busy = busy;
+            for (PyObject *die : *game->dice) {
+                reinterpret_cast<DieObject *>(die)->busy = busy;
+            }
+        };
+        markBusy(true);
+        GameOutcome outcome;
+        bool failed = false;
+        Py_BEGIN_ALLOW_THREADS
+        try {
+            outcome = simulateGame(*game->engine, *game->players, rounds);
+        } catch (const std::exception &) {
+            failed = true;
+        }
+        Py_END_ALLOW_THREADS
+        markBusy(false);
+        if (failed) {
+            PyErr_SetString(PyExc_ValueError, "invalid number of dice or players");
+            return nullptr;
+        }
+        PyObject *balances = PyList_New(static_cast<Py_ssize_t>(outcome.balances.size()));
+        for (std::size_t i = 0; i < outcome.balances.size(); i++) {
+            PyList_SET_ITEM(balances, i, PyLong_FromUnsignedLong(outcome.balances[i]));
+        }
+        return Py_BuildValue("(iIN)", outcome.winner, outcome.rounds, balances);
+    }
+
+    PyMethodDef gameMethods[] = {
+        {"add_die", gameAddDie, METH_O, "Add a worldcup.RandomDie."},
+        {"add_player", gameAddPlayer, METH_O, "Add a player by name."},
+        {"play", gamePlay, METH_VARARGS, "Play one game; returns (winner seat, rounds, balances)."},
+        {nullptr, nullptr, 0, nullptr}
+    };
+
+    PyType_Slot gameSlots[] = {
+        {Py_tp_new, reinterpret_cast<void *>(gameNew)},
+        {Py_tp_dealloc, reinterpret_cast<void *>(gameDealloc)},
+        {Py_tp_methods, gameMethods},
+        {Py_tp_doc, const_cast<char *>("WorldCup2022 engine.")},
+        {0, nullptr}
+    };
+
+    PyType_Spec gameSpec = {"worldcup.WorldCup2022", sizeof(GameObject), 0, Py_TPFLAGS_DEFAULT, gameSlots};
+
+    PyTypeObject *GameType = nullptr;
+
+    // simulate(players, games, rounds=100, seed=0, dice=None, threads=1)
+    //   -> (winners, rounds, balances)
+    // Gra g używa kostek zasianych z seed + g, więc wynik nie zależy od
+    // liczby wątków.
+    PyObject *simulate(PyObject *, PyObject *args, PyObject *kwargs) {
+        static const char *keywords[] = {"players", "games", "rounds", "seed", "dice", "threads", "rules", nullptr};
+        PyObject *playersArg = nullptr;
+        PyObject *diceArg = Py_None;
+        unsigned long long games = 0;
+        unsigned int rounds = 100;
+        unsigned long long seed = 0;
+        unsigned int threads = 1;
+        const char *rulesName = "standard";
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OK|IKOIs", const_cast<char **>(keywords), &playersArg,
+                                         &games, &rounds, &seed, &diceArg, &threads, &rulesName)) {
+            return nullptr;
+        }
+        std::vector<std::string> players;
+        if (!toStrings(playersArg, players)) {
+            return nullptr;
+        }
+        const auto &names = ruleVariantNames();
+        auto rule = std::find_if(names.begin(), names.end(),
+                                 [rulesName](const auto &entry) { return entry.first == rulesName; });
+        if (rule == names.end()) {
+            PyErr_SetString(PyExc_ValueError, "rules must be standard, threeDice or strictBookmaker");
+            return nullptr;
+        }
+        const RuleVariant variant = rule->second;
+        std::vector<std::vector<double>> dice;
+        if (diceArg == Py_None) {
+            unsigned int diesNumber = dispatchRules(variant, [](auto rules) { return rules.diesNumber; });
+            dice.assign(diesNumber, fairDieWeights(6));
+        } else {
+            PyObject *items = PySequence_Fast(diceArg, "dice must be a sequence of weight sequences");
+            if (items == nullptr) {
+                return nullptr;
+            }
+            for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(items); i++) {
+                dice.emplace_back();
+                if (!toWeights(PySequence_Fast_GET_ITEM(items, i), dice.back())) {
+                    Py_DECREF(items);
+                    return nullptr;
+                }
+            }
+            Py_DECREF(items);
+        }
+
+        auto results = std::make_shared<BatchResults>();
+        results->games = games;
+        results->players = players.size();
+        results->winners.resize(games);
+        results->rounds.resize(games);
+        results->balances.resize(games * players.size());
+
+        std::atomic<bool> failed = false;
+        Py_BEGIN_ALLOW_THREADS
+        auto work = [&](std::uint64_t begin, std::uint64_t end) {
+            try {
+                dispatchRules(variant, [&](auto rules) {
+                    BasicWorldCup<decltype(rules)> engine;
+                    std::vector<std::shared_ptr<RandomDie>> ownDice;
+                    for (const auto &weights : dice) {
+                        ownDice.push_back(std::make_shared<RandomDie>(weights));
+                        engine.addDie(ownDice.back());
+                    }
+                    simulateSeededRange(engine, ownDice, players, rounds, seed + begin, seed + end,
+                                        [&](std::uint64_t gameSeed, const GameOutcome &outcome) {
+                                            std::uint64_t g = gameSeed - seed;
+                                            results->winners[g] = outcome.winner;
+                                            results->rounds[g] = outcome.rounds;
+                                            std::copy(outcome.balances.begin(), outcome.balances.end(),
+                                                      results->balances.begin() + g * players.size());
+                                        });
+                });
+            } catch (const std::exception &) {
+                failed = true;
+            }
+        };
+        threads = std::max(threads, 1u);
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < threads; t++) {
+            workers.emplace_back(work, games * t / threads, games * (t + 1) / threads);
+        }
+        work(0, games / threads);
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        Py_END_ALLOW_THREADS
+        if (failed) {
+            PyErr_SetString(PyExc_ValueError, "invalid number of dice or players");
+            return nullptr;
+        }
+
+        PyObject *winners = makeArray(results, results->winners, "i", games, 0);
+        PyObject *roundsArray = makeArray(results, results->rounds, "I", games, 0);
+        PyObject *balances = makeArray(results, results->balances, "I", games, players.size());
+        if (winners == nullptr || roundsArray == nullptr || balances == nullptr) {
+            Py_XDECREF(winners);
+            Py_XDECREF(roundsArray);
+            Py_XDECREF(balances);
+            return nullptr;
+        }
+        return Py_BuildValue("(NNN)", winners, roundsArray, balances);
+    }
+
+    PyMethodDef moduleMethods[] = {
+        {"simulate", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(simulate)),
+         METH_VARARGS | METH_KEYWORDS,
+         "simulate(players, games, rounds=100, seed=0, dice=None, threads=1, rules='standard') -> "
+         "(winners, rounds, balances)"},
+        {nullptr, nullptr, 0, nullptr}
+    };
+
+    PyModuleDef moduleDefinition = {PyModuleDef_HEAD_INIT, "worldcup", "WorldCup2022 engine bindings.", -1,
+                                    moduleMethods, nullptr, nullptr, nullptr, nullptr};
+
+}
+
+PyMODINIT_FUNC PyInit_worldcup() {
+    ArrayType = reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&arraySpec));
+    DieType = reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&dieSpec));
+    GameType = reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&gameSpec));
+    if (ArrayType == nullptr || DieType == nullptr || GameType == nullptr) {
+        return nullptr;
+    }
+    PyObject *module = PyModule_Create(&moduleDefinition);
+    if (module == nullptr) {
+        return nullptr;
+    }
+    if (PyModule_AddObjectRef(module, "RandomDie", reinterpret_cast<PyObject *>(DieType)) < 0 ||
+        PyModule_AddObjectRef(module, "WorldCup2022", reinterpret_cast<PyObject *>(GameType)) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -18,5 +18,22 @@ int main() {
     resultTestThree();
     fractionsTest();
     bankruptTest();
+    leagueTest();
+    multiScoreBoardTest();
+    engineRollsTest();
+    ruleVariantTest();
+    customRulesTest();
+    fieldPluginTest();
+    tournamentTest();
+    columnarExportTest();
+    importanceSamplingTest();
+    sequentialEstimatorTest();
+    liveLeaderboardTest();
+    histogramTest();
+    compactGameParityTest();
+    mctsAgentTest();
+    simulationDaemonTest();
+    shardedSimulationTest();
+    markovSolverTest();
     std::cout << CYAN << "All tests passed succesfully\n" << RESET;
 }
\ No newline at end of file
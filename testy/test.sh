@@ -1,5 +1,5 @@
-g++ -std=c++20 -Wall -Wextra -O2 -o worldcup test.cc
+g++ -std=c++20 -Wall -Wextra -O2 -I.. -o worldcup test.cc ../worldcup2022.cc
 if [ $? -eq 0 ]
     then ./worldcup
-    else echo "Compilation failed. Try again manually with g++ -std=c++2a -Wall -Wextra -O2 -o worldcup test.cc && ./worldcup"
-fi
\ No newline at end of file
+    else echo "Compilation failed. Try again manually with g++ -std=c++2a -Wall -Wextra -O2 -I.. -o worldcup test.cc ../worldcup2022.cc && ./worldcup"
+fi
@@ -10,7 +10,26 @@
 #include <memory>
 #include <string>
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <thread>
 #include "worldcup2022.h"
+#include "worldcup_random_dice.h"
+#include "worldcup_multiscoreboard.h"
+#include "worldcup_plugin_library.h"
+#include "worldcup_export.h"
+#include "worldcup_estimation.h"
+#include "worldcup_shards.h"
+#include "worldcup_leaderboard.h"
+#include "worldcup_histogram.h"
+#include "worldcup_mcts.h"
+#include "worldcup_daemon.h"
+#include "worldcup_tournament.h"
+#include "worldcup_markov.h"
 #include <iostream>
 #include "scoreboard.h"
 #include "test_dice.h"
@@ -337,5 +356,1117 @@ void bankruptTest() {
     std::cout << GREEN << "Bankrupt test ended\n" << RESET;
 }
 
+// Gracz, który zawsze odpuszcza turę.
+class SitOutAgent : public TurnAgent {
+public:
+    bool sitOut([[maybe_unused]] const GameSnapshot &snapshot) override {
+        return true;
+    }
+};
+
+// Tryb ligowy: więcej niż DefaultRules::maxPlayers graczy, ranking zgodny ze zwycięzcą.
+void leagueTest() {
+    std::cout << RESET << "League test running\n" << RESET;
+
+    std::shared_ptr<Die> die1 = std::make_shared<MatthewDie>();
+    std::shared_ptr<Die> die2 = std::make_shared<PopeDie>();
+
+    std::shared_ptr<TextScoreBoard> scoreboard = std::make_shared<TextScoreBoard>();
+
+    std::shared_ptr<WorldCup2022> worldCup2022 = std::make_shared<WorldCup2022>();
+    worldCup2022->enableLeagueMode();
+    worldCup2022->addDie(die1);
+    worldCup2022->addDie(die2);
+    for (unsigned int i = 0; i < 1000; i++) {
+        worldCup2022->addPlayer("Gracz " + std::to_string(i));
+    }
+    worldCup2022->setScoreBoard(scoreboard);
+
+    worldCup2022->play(3);
+
+    auto top = worldCup2022->topPlayers(10);
+
+    std::cerr << RED;
+    assert(top.size() == 10);
+    for (unsigned int i = 1; i < top.size(); i++) {
+        assert(top[i - 1].second >= top[i].second);
+    }
+    std::string const result = scoreboard->str();
+    assert(result.substr(result.rfind("=== Zwycięzca: ")) == "=== Zwycięzca: " + top[0].first + "\n");
+
+    // Gracz dodany po bankructwie innego nie może dostać numeru gracza,
+    // który nadal jest w grze (ranking zgubiłby jednego z nich).
+    std::shared_ptr<WorldCup2022> again = std::make_shared<WorldCup2022>();
+    again->addDie(std::make_shared<MatthewDie>());
+    again->addDie(std::make_shared<PopeDie>());
+    again->addPlayer("Asterix", std::make_shared<SitOutAgent>());
+    again->addPlayer("Obelix");
+    again->addPlayer("Idefix", std::make_shared<SitOutAgent>());
+    again->play(2);
+    again->addPlayer("Panoramix");
+    again->play(0);
+
+    assert(again->topPlayers(10).size() == 3);
+
+    std::cout << GREEN << "League test passed\n\n" << RESET;
+}
+
+// Rozsyłanie zdarzeń do wielu tablic wyników z filtrowaniem.
+void multiScoreBoardTest() {
+    std::cout << RESET << "Multi scoreboard test running\n" << RESET;
+
+    std::shared_ptr<Die> die1 = std::make_shared<MatthewDie>();
+    std::shared_ptr<Die> die2 = std::make_shared<PopeDie>();
+
+    std::shared_ptr<TextScoreBoard> everything = std::make_shared<TextScoreBoard>();
+    std::shared_ptr<TextScoreBoard> changes = std::make_shared<TextScoreBoard>();
+    std::shared_ptr<TextScoreBoard> winner = std::make_shared<TextScoreBoard>();
+    std::shared_ptr<TextScoreBoard> rounds = std::make_shared<TextScoreBoard>();
+    std::shared_ptr<MultiScoreBoard> scoreboard = std::make_shared<MultiScoreBoard>();
+    scoreboard->addScoreBoard(everything);
+    scoreboard->addScoreBoard(changes, MultiScoreBoard::statusChanges);
+    scoreboard->addScoreBoard(winner, MultiScoreBoard::wins);
+    scoreboard->addScoreBoard(rounds, MultiScoreBoard::rounds);
+
+    std::shared_ptr<WorldCup> worldCup2022 = std::make_shared<WorldCup2022>();
+    worldCup2022->addDie(die1);
+    worldCup2022->addDie(die2);
+    worldCup2022->addPlayer("Bitek");
+    worldCup2022->addPlayer("Bajtek");
+    worldCup2022->setScoreBoard(scoreboard);
+
+    worldCup2022->play(6);
+
+    std::cerr << RED;
+    assert(everything->str() ==
+           "=== Runda: 0\n"
+           "Bitek [w grze] [40] - Mecz z Argentyną\n"
+           "Bajtek [w grze] [140] - Bukmacher\n"
+           "=== Runda: 1\n"
+           "Bitek [*** bankrut ***] [0] - Żółta kartka\n"
+           "=== Zwycięzca: Bajtek\n");
+    assert(changes->str() ==
+           "Bitek [w grze] [40] - Mecz z Argentyną\n"
+           "Bajtek [w grze] [140] - Bukmacher\n"
+           "Bitek [*** bankrut ***] [0] - Żółta kartka\n");
+    assert(winner->str() == "=== Zwycięzca: Bajtek\n");
+    assert(rounds->str() ==
+           "=== Runda: 0\n"
+           "=== Runda: 1\n");
+
+    std::cout << GREEN << "Multi scoreboard test passed\n\n" << RESET;
+}
+
+// Zasady z tak dużym saldem, że nikt nie bankrutuje, więc gra trwa wszystkie
+// rundy i każdy ruch gracza daje jedną próbkę sumy oczek.
+struct RichRules : DefaultRules {
+    static constexpr unsigned int startingBalance = 1u << 30;
+};
+
+struct RichThreeDiceRules : RichRules {
+    static constexpr unsigned int diesNumber = 3;
+};
+
+// Pole bez akcji; wydłuża planszę, żeby przesunięcie gracza było równe rzutowi.
+class EmptyField : public FieldPlugin {
+public:
+    [[nodiscard]] std::string name() const override {
+        return "Pusto";
+    }
+};
+
+// Zlicza rzuty jako przesunięcia gracza między kolejnymi decyzjami.
+class RollCountingAgent : public TurnAgent {
+private:
+    std::shared_ptr<std::vector<std::uint64_t>> counts;
+    unsigned int boardSize;
+    std::vector<unsigned int> lastPosition;
+
+public:
+    RollCountingAgent(std::shared_ptr<std::vector<std::uint64_t>> counts, unsigned int boardSize) :
+                      counts(std::move(counts)), boardSize(boardSize) {}
+
+    bool sitOut(const GameSnapshot &snapshot) override {
+        unsigned int const id = snapshot.ids[snapshot.current];
+        unsigned int const position = snapshot.positions[snapshot.current];
+        if (id < lastPosition.size()) {
+            (*counts)[(position + boardSize - lastPosition[id]) % boardSize]++;
+        }
+        lastPosition.resize(std::max<std::size_t>(lastPosition.size(), id + 1));
+        lastPosition[id] = position;
+        return false;
+    }
+};
+
+// Losuje sumy oczek ścieżką silnika (tablica aliasów z sumDistribution
+// i generator pierwszej kostki) i porównuje częstości z rozkładem.
+template<typename Rules>
+void checkEngineRolls(const std::vector<std::vector<double>> &weights) {
+    BasicWorldCup<Rules> worldCup;
+    for (std::size_t d = 0; d < weights.size(); d++) {
+        worldCup.addDie(std::make_shared<RandomDie>(weights[d], 17 + d));
+    }
+    for (unsigned int field = 0; field < 20; field++) {
+        worldCup.addField(std::make_shared<EmptyField>());
+    }
+    unsigned int const boardSize = worldCup.boardLayout().size();
+    auto counts = std::make_shared<std::vector<std::uint64_t>>(boardSize, 0);
+    auto agent = std::make_shared<RollCountingAgent>(counts, boardSize);
+    worldCup.addPlayer("Bitek", agent);
+    worldCup.addPlayer("Bajtek", agent);
+    worldCup.play(50000);
+
+    std::vector<double> const expected = sumDistribution(weights);
+    assert(expected.size() < boardSize);
+    std::uint64_t total = 0;
+    for (std::uint64_t count : *counts) {
+        total += count;
+    }
+    assert(total > 90000);
+    for (std::size_t sum = 0; sum < boardSize; sum++) {
+        double const p = sum < expected.size() ? expected[sum] : 0.0;
+        double const frequency = static_cast<double>((*counts)[sum]) / static_cast<double>(total);
+        if (p == 0.0) {
+            assert((*counts)[sum] == 0);
+        } else {
+            assert(std::abs(frequency - p) <= 5.0 * std::sqrt(p * (1.0 - p) / static_cast<double>(total)));
+        }
+    }
+}
+
+void engineRollsTest() {
+    std::cout << RESET << "Engine rolls test running\n" << RESET;
+
+    std::cerr << RED;
+    checkEngineRolls<RichRules>({fairDieWeights(6), fairDieWeights(6)});
+    checkEngineRolls<RichThreeDiceRules>({fairDieWeights(6), fairDieWeights(6), fairDieWeights(6)});
+    checkEngineRolls<RichRules>({{0.0, 5.0, 0.0, 0.0, 1.0, 0.0, 2.0}, fairDieWeights(6)});
+
+    std::cout << GREEN << "Engine rolls test passed\n\n" << RESET;
+}
+
+// Wariant zasad z trzema kostkami wybierany w czasie działania programu.
+void ruleVariantTest() {
+    std::cout << RESET << "Rule variant test running\n" << RESET;
+
+    std::shared_ptr<TextScoreBoard> scoreboard = std::make_shared<TextScoreBoard>();
+
+    std::shared_ptr<WorldCup> worldCup2022 = makeWorldCup(RuleVariant::threeDice);
+    worldCup2022->addDie(std::make_shared<SnakeEyeDie>());
+    worldCup2022->addDie(std::make_shared<SnakeEyeDie>());
+    worldCup2022->addPlayer("Bitek");
+    worldCup2022->addPlayer("Bajtek");
+    worldCup2022->setScoreBoard(scoreboard);
+
+    bool passed = false;
+
+    try {
+        worldCup2022->play(1);
+    } catch (std::exception& e) {
+        passed = true;
+    }
+
+    std::cerr << RED;
+    assert(passed);
+
+    worldCup2022->addDie(std::make_shared<SnakeEyeDie>());
+    worldCup2022->play(1);
+
+    assert(scoreboard->str() ==
+           "=== Runda: 0\n"
+           "Bitek [w grze] [840] - Mecz z Lichtensteinem\n"
+           "Bajtek [w grze] [840] - Mecz z Lichtensteinem\n"
+           "=== Zwycięzca: Bitek\n");
+
+    std::cout << GREEN << "Rule variant test passed\n\n" << RESET;
+}
+
+// Własne zasady spoza RuleVariant: definicje metod silnika pochodzą
+// z nagłówka, więc BasicWorldCup<BonusRules> nie wymaga jawnej konkretyzacji.
+struct BonusRules : DefaultRules {
+    static constexpr unsigned int startingBalance = 500;
+    static constexpr unsigned int startBonus = 70;
+};
+
+void customRulesTest() {
+    std::cout << RESET << "Custom rules test running\n" << RESET;
+
+    std::shared_ptr<TextScoreBoard> scoreboard = std::make_shared<TextScoreBoard>();
+
+    BasicWorldCup<BonusRules> worldCup;
+    worldCup.addDie(std::make_shared<SnakeEyeDie>());
+    worldCup.addDie(std::make_shared<SnakeEyeDie>());
+    worldCup.addPlayer("Bitek");
+    worldCup.addPlayer("Bajtek");
+    worldCup.setScoreBoard(scoreboard);
+    worldCup.play(1);
+
+    std::cerr << RED;
+    assert(worldCup.boardLayout()[0].amount == BonusRules::startBonus);
+    assert(scoreboard->str() ==
+           "=== Runda: 0\n"
+           "Bitek [w grze] [340] - Dzień wolny od treningu\n"
+           "Bajtek [w grze] [340] - Dzień wolny od treningu\n"
+           "=== Zwycięzca: Bitek\n");
+
+    std::cout << GREEN << "Custom rules test passed\n\n" << RESET;
+}
+
+// Pole z wtyczki: premia i jedna tura przerwy dla zatrzymującego się gracza.
+class SponsorField : public FieldPlugin {
+public:
+    [[nodiscard]] std::string name() const override {
+        return "Sponsor";
+    }
+
+    void onPlayerStop(FieldPlayer &player) override {
+        player.addMoney(500);
+        player.suspend(1);
+    }
+};
+
+// Pole z wtyczki dopisane do planszy oraz domyślna obsługa partii torów.
+void fieldPluginTest() {
+    std::cout << RESET << "Field plugin test running\n" << RESET;
+
+    std::shared_ptr<TextScoreBoard> scoreboard = std::make_shared<TextScoreBoard>();
+
+    std::shared_ptr<WorldCup2022> worldCup2022 = std::make_shared<WorldCup2022>();
+    worldCup2022->addField(std::make_shared<SponsorField>());
+    worldCup2022->addDie(std::make_shared<SnakeEyeDie>());
+    worldCup2022->addDie(std::make_shared<SnakeEyeDie>());
+    worldCup2022->addPlayer("Bitek");
+    worldCup2022->addPlayer("Bajtek");
+    worldCup2022->setScoreBoard(scoreboard);
+
+    worldCup2022->play(10);
+
+    std::vector<SquareSpec> layout = worldCup2022->boardLayout();
+    std::string const expected =
+           "=== Runda: 7\n"
+           "Bitek [*** czekanie: 2 ***] [820] - Sponsor\n"
+           "Bajtek [*** czekanie: 2 ***] [820] - Sponsor\n"
+           "=== Runda: 8\n"
+           "Bitek [*** czekanie: 1 ***] [820] - Sponsor\n"
+           "Bajtek [*** czekanie: 1 ***] [820] - Sponsor\n"
+           "=== Runda: 9\n"
+           "Bitek [w grze] [1190] - Mecz z San Marino\n"
+           "Bajtek [w grze] [870] - Mecz z San Marino\n"
+           "=== Zwycięzca: Bitek\n";
+    std::string const result = scoreboard->str();
+
+    std::cerr << RED;
+    assert(layout.size() == 13);
+    assert(layout.back().kind == SquareSpec::custom && layout.back().name == "Sponsor");
+    assert(result.substr(result.find("=== Runda: 7")) == expected);
+
+    unsigned int money[2] = {100, 200};
+    int suspension[2] = {0, 0};
+    bool bankrupt[2] = {false, false};
+    SponsorField().onPlayersStop({2, money, suspension, bankrupt});
+    assert(money[0] == 600 && money[1] == 700);
+    assert(suspension[0] == 1 && suspension[1] == 1);
+
+    // Wtyczka z biblioteki współdzielonej, jeśli podano jej ścieżkę.
+    if (char const *path = std::getenv("WORLDCUP_TAX_PLUGIN")) {
+        std::shared_ptr<FieldPlugin> tax = FieldPluginLibrary(path).field("50");
+        assert(tax->name() == "Urząd skarbowy");
+        tax->onPlayersPass({2, money, suspension, bankrupt});
+        assert(money[0] == 300 && money[1] == 350 && !bankrupt[0] && !bankrupt[1]);
+    }
+
+    std::cout << GREEN << "Field plugin test passed\n\n" << RESET;
+}
+
+// Turniej: drabinka pucharowa rozgrywana na wielu wątkach i błąd w rozgrywce.
+void tournamentTest() {
+    std::cout << RESET << "Tournament test running\n" << RESET;
+
+    // Kostki bez stanu, więc wynik rozgrywki zależy tylko od jej graczy,
+    // a nie od wątku, który ją rozegrał.
+    auto dice = [] {
+        return std::vector<std::shared_ptr<Die>>{std::make_shared<SnakeEyeDie>(),
+                                                 std::make_shared<SnakeEyeDie>()};
+    };
+    auto bracket = [](Tournament &tournament) {
+        std::vector<unsigned int> stage;
+        for (unsigned int group = 0; group < 8; group++) {
+            stage.push_back(tournament.addGame({"Gracz " + std::to_string(2 * group),
+                                                "Gracz " + std::to_string(2 * group + 1)}, {}, 20));
+        }
+        while (stage.size() > 1) {
+            std::vector<unsigned int> next;
+            for (unsigned int i = 0; i < stage.size(); i += 2) {
+                next.push_back(tournament.addGame({}, {stage[i], stage[i + 1]}, 20));
+            }
+            stage = next;
+        }
+    };
+
+    Tournament sequential(dice);
+    bracket(sequential);
+    sequential.run(1);
+    Tournament parallel(dice);
+    bracket(parallel);
+    parallel.run(4);
+
+    std::cerr << RED;
+    assert(sequential.size() == 15);
+    for (unsigned int game = 0; game < sequential.size(); game++) {
+        assert(!sequential.winner(game).empty());
+        assert(sequential.winner(game) == parallel.winner(game));
+    }
+    // Zwycięzca rozgrywki jest jednym ze zwycięzców jej dostawców, więc
+    // rozgrywka zależna została rozegrana dopiero po nich.
+    for (unsigned int game = 8; game < 15; game++) {
+        unsigned int const feeder = 2 * (game - 8);
+        assert(parallel.winner(game) == parallel.winner(feeder) ||
+               parallel.winner(game) == parallel.winner(feeder + 1));
+    }
+
+    // Rozgrywka z jednym graczem rzuca wyjątek, który run() rzuca ponownie
+    // po rozegraniu pozostałych rozgrywek.
+    Tournament broken(dice);
+    unsigned int const lonely = broken.addGame({"Samotnik"});
+    unsigned int const fine = broken.addGame({"Bitek", "Bajtek"});
+    broken.addGame({"Bolek"}, {lonely, fine});
+    bool passed = false;
+    try {
+        broken.run(3);
+    } catch (std::exception &e) {
+        passed = true;
+    }
+    assert(passed);
+    assert(broken.winner(lonely).empty());
+    assert(!broken.winner(fine).empty());
+
+    std::cout << GREEN << "Tournament test passed\n\n" << RESET;
+}
+
+// Zapamiętuje wiersze widziane przez silnik i przekazuje je do eksportera.
+class TeeRecorder : public RoundRecorder {
+public:
+    std::shared_ptr<ColumnarExporter> exporter;
+    std::vector<std::vector<std::uint64_t>> players;
+    std::vector<std::vector<std::uint64_t>> pots;
+    std::uint64_t games = 0;
+
+    explicit TeeRecorder(std::shared_ptr<ColumnarExporter> exporter) : exporter(std::move(exporter)) {}
+
+    void onGameStart() override {
+        games++;
+        exporter->onGameStart();
+    }
+
+    void onPlayerState(unsigned int roundNo, unsigned int playerId, unsigned int position,
+                       unsigned int money, unsigned int suspension) override {
+        players.push_back({games - 1, roundNo, playerId, position, money, suspension});
+        exporter->onPlayerState(roundNo, playerId, position, money, suspension);
+    }
+
+    void onPot(unsigned int roundNo, unsigned int square, unsigned int pot) override {
+        pots.push_back({games - 1, roundNo, square, pot});
+        exporter->onPot(roundNo, square, pot);
+    }
+};
+
+// Odczytuje wszystkie kolumny pliku jako wiersze.
+std::vector<std::vector<std::uint64_t>> readColumnar(const std::string &path) {
+    columnar::Reader reader(path);
+    std::vector<std::vector<std::uint64_t>> rows;
+    std::vector<std::uint64_t> values;
+    for (std::size_t chunk = 0; chunk < reader.chunkCount(); chunk++) {
+        std::size_t const first = rows.size();
+        rows.resize(first + reader.rows(chunk), std::vector<std::uint64_t>(reader.columnCount()));
+        for (std::size_t column = 0; column < reader.columnCount(); column++) {
+            reader.column(chunk, column, values);
+            assert(values.size() == reader.rows(chunk));
+            for (std::size_t row = 0; row < values.size(); row++) {
+                rows[first + row][column] = values[row];
+            }
+        }
+    }
+    return rows;
+}
+
+// Eksport kolumnowy kilku rozgrywek w wielu porcjach i odczyt uszkodzonego pliku.
+void columnarExportTest() {
+    std::cout << RESET << "Columnar export test running\n" << RESET;
+
+    std::string const prefix = (std::filesystem::temp_directory_path() /
+                                ("worldcup_test_" + std::to_string(::getpid()))).string();
+    auto recorder = std::make_shared<TeeRecorder>(std::make_shared<ColumnarExporter>(prefix, 0, 7));
+    {
+        std::shared_ptr<WorldCup2022> worldCup2022 = std::make_shared<WorldCup2022>();
+        worldCup2022->addDie(std::make_shared<MatthewDie>());
+        worldCup2022->addDie(std::make_shared<PopeDie>());
+        worldCup2022->setRoundRecorder(recorder);
+        for (unsigned int game = 0; game < 3; game++) {
+            worldCup2022->removePlayers();
+            worldCup2022->addPlayer("Bitek");
+            worldCup2022->addPlayer("Bajtek");
+            worldCup2022->addPlayer("Bolek");
+            worldCup2022->play(10);
+        }
+    }
+    // Zniszczenie eksportera zapisuje ostatnie, niepełne porcje.
+    recorder->exporter.reset();
+
+    std::cerr << RED;
+    assert(recorder->games == 3);
+    assert(recorder->players.size() > 7 && recorder->pots.size() > 7);
+    assert(readColumnar(prefix + ".players.wcc") == recorder->players);
+    assert(readColumnar(prefix + ".pots.wcc") == recorder->pots);
+
+    // Plik ucięty w środku ostatniej porcji.
+    std::string const truncated = prefix + ".truncated.wcc";
+    std::filesystem::copy_file(prefix + ".players.wcc", truncated);
+    std::filesystem::resize_file(truncated, std::filesystem::file_size(truncated) - 3);
+    bool passed = false;
+    try {
+        columnar::Reader reader(truncated);
+    } catch (columnar::ColumnarFileException &e) {
+        passed = true;
+    }
+    assert(passed);
+
+    for (std::string const suffix : {".players.wcc", ".pots.wcc", ".truncated.wcc"}) {
+        std::filesystem::remove(prefix + suffix);
+    }
+
+    std::cout << GREEN << "Columnar export test passed\n\n" << RESET;
+}
+
+// Losowanie istotnościowe długiej gry zgodne ze zwykłym Monte Carlo.
+void importanceSamplingTest() {
+    std::cout << RESET << "Importance sampling test running\n" << RESET;
+
+    // Przy uczciwych kostkach mniej niż 1% gier dwóch graczy trwa 4 rundy.
+    auto longGame = [](const GameOutcome &outcome) {
+        return outcome.rounds >= 4;
+    };
+    std::vector<double> const fair = fairDieWeights(6);
+
+    ImportanceSampler sampler({"Bitek", "Bajtek"}, fair, exponentialTilt(fair, -0.3), 10, 7);
+    Estimate const tilted = sampler.estimate(longGame, 20000);
+
+    SequentialEstimator::StoppingRule rule;
+    rule.halfWidth = 0.0;
+    rule.maxGames = 40000;
+    SequentialEstimator plain({"Bitek", "Bajtek"}, 10, fair, 7);
+    Estimate const direct = plain.estimate(longGame, rule);
+
+    std::cerr << RED;
+    assert(direct.games == 40000);
+    assert(direct.value > 0.001 && direct.value < 0.05);
+    assert(tilted.standardError < direct.standardError);
+    assert(std::abs(tilted.value - direct.value) <=
+           4.0 * std::hypot(tilted.standardError, direct.standardError));
+
+    // Rozkład bez szóstki nie pokrywa nominalnego, a estymator byłby obciążony.
+    std::vector<double> noSix = fair;
+    noSix[6] = 0.0;
+    std::vector<double> const fourSides = fairDieWeights(4);
+    for (std::vector<double> const &proposal : {noSix, fourSides}) {
+        bool passed = false;
+        try {
+            TiltedDie die(fair, proposal, std::make_shared<LikelihoodRatio>());
+        } catch (TiltedDie::UncoveredOutcomeException &e) {
+            passed = true;
+        }
+        assert(passed);
+    }
+
+    std::cout << GREEN << "Importance sampling test passed\n\n" << RESET;
+}
+
+// Wynik serii gier nie zależy od liczby procesów.
+void shardedSimulationTest() {
+    std::cout << RESET << "Sharded simulation test running\n" << RESET;
+
+    ShardedSimulation simulation({"Bitek", "Bajtek", "Bolek"}, 50);
+    ShardTotals const single = simulation.run(0, 2000, 1);
+    ShardTotals const sharded = simulation.run(0, 2000, 4);
+
+    std::cerr << RED;
+    assert(single.games == 2000);
+    assert(single == sharded);
+    std::uint64_t wins = single.noWinner;
+    for (std::uint64_t seatWins : single.wins) {
+        wins += seatWins;
+    }
+    assert(wins == 2000);
+    // Ziarna [0, 1000) i [1000, 2000) dają razem to samo co [0, 2000).
+    ShardTotals halves = simulation.run(0, 1000, 3);
+    halves.merge(simulation.run(1000, 1000, 2));
+    assert(halves == single);
+
+    // Wariant z trzema kostkami: inne wyniki, nadal niezależne od podziału.
+    ShardedSimulation threeDice({"Bitek", "Bajtek", "Bolek"}, 50, fairDieWeights(6), RuleVariant::threeDice);
+    ShardTotals const three = threeDice.run(0, 2000, 3);
+    assert(three.games == 2000 && three == threeDice.run(0, 2000, 1));
+    assert(!(three == single));
+
+    std::cout << GREEN << "Sharded simulation test passed\n\n" << RESET;
+}
+
+// Trzy warunki zatrzymania estymatora sekwencyjnego.
+void sequentialEstimatorTest() {
+    std::cout << RESET << "Sequential estimator test running\n" << RESET;
+
+    auto firstWins = [](const GameOutcome &outcome) {
+        return outcome.winner == 0;
+    };
+    SequentialEstimator estimator({"Bitek", "Bajtek"}, 20, fairDieWeights(6), 3);
+
+    std::cerr << RED;
+    assert(std::abs(twoSidedNormalQuantile(0.05) - CONFIDENCE_Z) < 1e-9);
+
+    // Precyzja: przedział po ostatnim sprawdzeniu jest dość wąski, ale
+    // szerszy niż 95% przedział Wilsona dla tych samych liczb.
+    SequentialEstimator::StoppingRule precise;
+    precise.halfWidth = 0.03;
+    Estimate const converged = estimator.estimate(firstWins, precise);
+    auto const successes = static_cast<std::uint64_t>(std::llround(converged.value * converged.games));
+    Estimate const fixed = wilsonInterval(successes, converged.games);
+    assert(converged.converged);
+    assert(converged.games >= precise.minGames && converged.games % precise.batch == 0);
+    assert((converged.high - converged.low) / 2.0 <= precise.halfWidth);
+    assert(converged.high - converged.low > fixed.high - fixed.low);
+    assert(converged.low <= converged.value && converged.value <= converged.high);
+
+    // Termin: zegar jest sprawdzany po pierwszej partii.
+    SequentialEstimator::StoppingRule hurried;
+    hurried.halfWidth = 0.0;
+    hurried.deadline = std::chrono::nanoseconds(0);
+    Estimate const late = estimator.estimate(firstWins, hurried);
+    assert(!late.converged);
+    assert(late.games == hurried.batch);
+
+    // Limit gier, niebędący wielokrotnością partii.
+    SequentialEstimator::StoppingRule limited;
+    limited.halfWidth = 0.0;
+    limited.maxGames = 1000;
+    Estimate const capped = estimator.estimate(firstWins, limited);
+    assert(!capped.converged);
+    assert(capped.games == 1000);
+
+    std::cout << GREEN << "Sequential estimator test passed\n\n" << RESET;
+}
+
+// Tablica wyników na żywo: kawałek na wątek i spójne migawki w trakcie zapisu.
+void liveLeaderboardTest() {
+    std::cout << RESET << "Live leaderboard test running\n" << RESET;
+
+    std::vector<std::string> const players = {"Bitek", "Bajtek", "Bolek"};
+    LiveLeaderboard leaderboard(players, {"Żółta kartka"});
+    unsigned int const threads = 4;
+    unsigned int const gamesPerThread = 300;
+
+    std::atomic<bool> running = true;
+    std::atomic<bool> consistent = true;
+    // Każda migawka to całe gry: zwycięzca albo jego brak dla każdej gry,
+    // a liczba gier nie maleje między migawkami.
+    std::thread reader([&] {
+        std::uint64_t previous = 0;
+        while (running) {
+            LiveLeaderboard::Snapshot const snapshot = leaderboard.snapshot();
+            std::uint64_t bySeat = snapshot.noWinner;
+            std::uint64_t byName = snapshot.noWinner;
+            for (std::uint64_t wins : snapshot.winsBySeat) {
+                bySeat += wins;
+            }
+            for (std::uint64_t wins : snapshot.winsByName) {
+                byName += wins;
+            }
+            if (bySeat != snapshot.games || byName != snapshot.games || snapshot.games < previous) {
+                consistent = false;
+            }
+            previous = snapshot.games;
+        }
+    });
+
+    // Wątki czekają na siebie przed zakończeniem, więc żaden nie przejmie
+    // kawałka innego.
+    std::latch finished(threads);
+    std::vector<std::thread> writers;
+    for (unsigned int t = 0; t < threads; t++) {
+        writers.emplace_back([&, t] {
+            WorldCup2022 engine;
+            engine.addDie(std::make_shared<RandomDie>(fairDieWeights(6), 2 * t));
+            engine.addDie(std::make_shared<RandomDie>(fairDieWeights(6), 2 * t + 1));
+            for (unsigned int game = 0; game < gamesPerThread; game++) {
+                engine.removePlayers();
+                for (std::string const &player : players) {
+                    engine.addPlayer(player);
+                }
+                engine.setScoreBoard(leaderboard.session(players));
+                engine.play(20);
+            }
+            finished.arrive_and_wait();
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    running = false;
+    reader.join();
+
+    LiveLeaderboard::Snapshot const total = leaderboard.snapshot();
+
+    std::cerr << RED;
+    assert(consistent);
+    assert(total.games == threads * gamesPerThread);
+    assert(leaderboard.shardCount() == threads);
+
+    // Kolejne gry w jednym wątku piszą do jednego kawałka, a nowa tablica
+    // dostaje własny.
+    LiveLeaderboard other(players, {});
+    for (unsigned int game = 0; game < 3; game++) {
+        WorldCup2022 engine;
+        engine.addDie(std::make_shared<SnakeEyeDie>());
+        engine.addDie(std::make_shared<SnakeEyeDie>());
+        for (std::string const &player : players) {
+            engine.addPlayer(player);
+        }
+        engine.setScoreBoard(other.session(players));
+        engine.play(5);
+    }
+    assert(other.shardCount() == 1);
+    assert(other.snapshot().games == 3);
+    assert(leaderboard.snapshot().games == threads * gamesPerThread);
+
+    std::cout << GREEN << "Live leaderboard test passed\n\n" << RESET;
+}
+
+// Górna granica kubełka wartości (między skrajnymi wartościami histogramu).
+std::uint64_t bucketTop(std::uint64_t value) {
+    Histogram histogram;
+    histogram.record(0);
+    histogram.record(value);
+    histogram.record(~std::uint64_t(0));
+    return histogram.quantile(0.5);
+}
+
+// Zasady z mniejszym saldem początkowym niż domyślne.
+struct PoorRules : DefaultRules {
+    static constexpr unsigned int startingBalance = 300;
+};
+
+// Granice kubełków, błąd kwantyli, scalanie histogramów i histogramy
+// z rozegranych gier.
+void histogramTest() {
+    std::cout << RESET << "Histogram test running\n" << RESET;
+
+    std::cerr << RED;
+    // Poniżej 256 każda wartość ma własny kubełek, dalej kubełek ma szerokość
+    // 2^(wykładnik - 7).
+    assert(bucketTop(127) == 127);
+    assert(bucketTop(128) == 128);
+    assert(bucketTop(255) == 255);
+    assert(bucketTop(256) == 257);
+    for (unsigned int k = 9; k < 64; k++) {
+        std::uint64_t const power = std::uint64_t(1) << k;
+        assert(bucketTop(power - 1) == power - 1);
+        assert(bucketTop(power) == power + (power >> 7) - 1);
+    }
+    assert(bucketTop(~std::uint64_t(0)) == ~std::uint64_t(0));
+
+    // Kwantyl nie jest mniejszy od dokładnego i przekracza go o mniej niż 1%.
+    Histogram all;
+    Histogram even;
+    Histogram odd;
+    for (std::uint64_t value = 1; value <= 100000; value++) {
+        all.record(value);
+        (value % 2 == 0 ? even : odd).record(value);
+    }
+    for (double q : {0.0, 0.001, 0.1, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+        auto const exact = static_cast<std::uint64_t>(q * 99999.0) + 1;
+        std::uint64_t const estimate = all.quantile(q);
+        assert(exact <= estimate && estimate <= exact + exact / 128);
+    }
+    assert(all.quantile(0.0) == 1 && all.quantile(1.0) == 100000);
+
+    // Scalenie daje ten sam histogram co zapis wszystkich wartości do jednego.
+    Histogram merged;
+    merged.merge(even);
+    merged.merge(odd);
+    merged.merge(Histogram());
+    assert(merged.count() == all.count());
+    assert(merged.min() == 1 && merged.max() == 100000);
+    for (unsigned int permille = 0; permille <= 1000; permille++) {
+        assert(merged.quantile(permille / 1000.0) == all.quantile(permille / 1000.0));
+    }
+    assert(Histogram().min() == 0 && Histogram().quantile(0.5) == 0);
+
+    // Gry z zasianymi kostkami: histogramy z tablicy wyników zgadzają się
+    // z wynikami tych samych gier policzonymi przez simulateGame.
+    std::vector<std::string> const players = {"Bitek", "Bajtek", "Bolek"};
+    std::vector<std::shared_ptr<RandomDie>> const dice = {std::make_shared<RandomDie>(fairDieWeights(6)),
+                                                          std::make_shared<RandomDie>(fairDieWeights(6))};
+    BasicWorldCup<PoorRules> engine;
+    for (const auto &die : dice) {
+        engine.addDie(die);
+    }
+    auto const board = std::make_shared<HistogramScoreBoard>(players, PoorRules::startingBalance);
+    // Bankruci znikają z silnika, więc przed każdą grą gracze są dodawani
+    // od nowa.
+    auto reset = [&](std::uint64_t seed) {
+        for (std::size_t d = 0; d < dice.size(); d++) {
+            dice[d]->seed(seed * dice.size() + d);
+        }
+        engine.removePlayers();
+        for (const std::string &name : players) {
+            engine.addPlayer(name);
+        }
+    };
+    std::uint64_t const games = 40;
+    ResultHistograms expected;
+    std::uint64_t bankruptcies = 0;
+    for (std::uint64_t seed = 0; seed < games; seed++) {
+        reset(seed);
+        GameOutcome const outcome = simulateGame(engine, players, 30);
+        expected.add(outcome);
+        bankruptcies += std::count_if(outcome.bankruptcyRound.begin(), outcome.bankruptcyRound.end(),
+                                      [](unsigned int round) { return round != GameOutcome::NOT_BANKRUPT; });
+        reset(seed);
+        engine.setScoreBoard(board);
+        engine.play(30);
+    }
+    auto same = [](const Histogram &a, const Histogram &b) {
+        for (unsigned int permille = 0; permille <= 1000; permille++) {
+            if (a.quantile(permille / 1000.0) != b.quantile(permille / 1000.0)) {
+                return false;
+            }
+        }
+        return a.count() == b.count() && a.min() == b.min() && a.max() == b.max();
+    };
+    const ResultHistograms &collected = board->histograms();
+    assert(collected.rounds.count() == games && collected.finalBalance.count() == games * players.size());
+    assert(collected.bankruptcyRound.count() == bankruptcies && bankruptcies > 0);
+    assert(collected.rounds.max() <= 30 && collected.bankruptcyRound.max() < 30);
+    assert(same(collected.rounds, expected.rounds));
+    assert(same(collected.finalBalance, expected.finalBalance));
+    assert(same(collected.bankruptcyRound, expected.bankruptcyRound));
+
+    // Bez żadnej rundy wszyscy kończą z saldem początkowym z zasad silnika.
+    auto const empty = std::make_shared<HistogramScoreBoard>(players, PoorRules::startingBalance);
+    reset(0);
+    engine.setScoreBoard(empty);
+    engine.play(0);
+    assert(empty->histograms().rounds.count() == 1 && empty->histograms().rounds.max() == 0);
+    assert(empty->histograms().finalBalance.count() == players.size());
+    assert(empty->histograms().finalBalance.min() == PoorRules::startingBalance);
+    assert(empty->histograms().finalBalance.max() == PoorRules::startingBalance);
+    assert(empty->histograms().bankruptcyRound.count() == 0);
+
+    std::cout << GREEN << "Histogram test passed\n\n" << RESET;
+}
+
+// Agent, który zawsze rzuca i zapamiętuje stan gry przed każdym rzutem.
+class SnapshotAgent : public TurnAgent {
+public:
+    std::shared_ptr<std::vector<GameSnapshot>> snapshots;
+
+    explicit SnapshotAgent(std::shared_ptr<std::vector<GameSnapshot>> snapshots) :
+                           snapshots(std::move(snapshots)) {}
+
+    bool sitOut(const GameSnapshot &snapshot) override {
+        snapshots->push_back(snapshot);
+        return false;
+    }
+};
+
+// Kostka losowa zapisująca swoje rzuty. Nie jest DistributionDie, więc
+// silnik rzuca każdą kostką osobno.
+class RecordingDie : public Die {
+private:
+    RandomDie die;
+    std::shared_ptr<std::vector<unsigned short>> rolls;
+
+public:
+    RecordingDie(std::uint64_t seed, std::shared_ptr<std::vector<unsigned short>> rolls) :
+                 die(fairDieWeights(6), seed), rolls(std::move(rolls)) {}
+
+    [[nodiscard]] unsigned short roll() const override {
+        unsigned short result = die.roll();
+        rolls->push_back(result);
+        return result;
+    }
+};
+
+// CompactGame odtwarza każdą turę silnika: stan po rzucie (i po turach
+// czekania) równa się stanowi przed następnym rzutem silnika.
+void compactGameParityTest() {
+    std::cout << RESET << "Compact game parity test running\n" << RESET;
+
+    std::cerr << RED;
+    for (std::uint64_t seed = 0; seed < 3000; seed++) {
+        auto snapshots = std::make_shared<std::vector<GameSnapshot>>();
+        auto rolls = std::make_shared<std::vector<unsigned short>>();
+        WorldCup2022 engine;
+        engine.addDie(std::make_shared<RecordingDie>(2 * seed, rolls));
+        engine.addDie(std::make_shared<RecordingDie>(2 * seed + 1, rolls));
+        for (unsigned int player = 0; player < 2 + seed % 4; player++) {
+            engine.addPlayer("Gracz " + std::to_string(player), std::make_shared<SnapshotAgent>(snapshots));
+        }
+        engine.play(30);
+
+        std::vector<SquareSpec> const layout = engine.boardLayout();
+        assert(rolls->size() == 2 * snapshots->size());
+        for (std::size_t turn = 0; turn < snapshots->size(); turn++) {
+            CompactGame game(layout, (*snapshots)[turn]);
+            game.turn(false, (*rolls)[2 * turn] + (*rolls)[2 * turn + 1]);
+            while (!game.finished() && game.currentSuspended()) {
+                game.turn(false, 0);
+            }
+            if (turn + 1 < snapshots->size()) {
+                assert(game.hash() == CompactGame(layout, (*snapshots)[turn + 1]).hash());
+            } else {
+                assert(game.finished());
+            }
+        }
+    }
+
+    // Pól z wtyczek nie da się odtworzyć w symulacjach agenta.
+    WorldCup2022 plugged;
+    plugged.addField(std::make_shared<SponsorField>());
+    bool passed = false;
+    try {
+        MctsAgent agent(plugged.boardLayout(), sumDistribution({fairDieWeights(6), fairDieWeights(6)}));
+    } catch (MctsAgent::UnsupportedLayoutException &e) {
+        passed = true;
+    }
+    assert(passed);
+
+    std::cout << GREEN << "Compact game parity test passed\n\n" << RESET;
+}
+
+// Sprawdza po każdej decyzji agenta MCTS, że korzeń dostał wszystkie iteracje.
+class CheckedMctsAgent : public TurnAgent {
+private:
+    std::shared_ptr<MctsAgent> agent;
+    unsigned int iterations;
+
+public:
+    unsigned int decisions = 0;
+
+    CheckedMctsAgent(std::shared_ptr<MctsAgent> agent, unsigned int iterations) :
+                     agent(std::move(agent)), iterations(iterations) {}
+
+    bool sitOut(const GameSnapshot &snapshot) override {
+        bool decision = agent->sitOut(snapshot);
+        std::array<std::uint32_t, 2> const visits = agent->lastRootVisits();
+        assert(visits[0] + visits[1] == iterations);
+        assert(decision == (visits[1] > visits[0]));
+        decisions++;
+        return decision;
+    }
+};
+
+// Agent MCTS na wielu wątkach w pełnych grach. Tablica transpozycji ma tylko
+// 1024 miejsca, więc bez zwalniania wpisów poprzednich decyzji zapełniłaby
+// się po kilku decyzjach i korzeń przestałby dostawać odwiedziny.
+void mctsAgentTest() {
+    std::cout << RESET << "MCTS agent test running\n" << RESET;
+
+    std::cerr << RED;
+    WorldCup2022 engine;
+    engine.addDie(std::make_shared<RandomDie>(fairDieWeights(6), 1));
+    engine.addDie(std::make_shared<RandomDie>(fairDieWeights(6), 2));
+    MctsAgent::Settings settings;
+    settings.iterations = 300;
+    settings.threads = 4;
+    settings.tableBits = 10;
+    settings.seed = 7;
+    auto mcts = std::make_shared<MctsAgent>(engine.boardLayout(),
+                                            sumDistribution({fairDieWeights(6), fairDieWeights(6)}), settings);
+    auto agent = std::make_shared<CheckedMctsAgent>(mcts, settings.iterations);
+    for (unsigned int game = 0; game < 40; game++) {
+        engine.removePlayers();
+        engine.addPlayer("Agent", agent);
+        engine.addPlayer("Bitek");
+        engine.addPlayer("Bajtek");
+        engine.play(40);
+    }
+    assert(agent->decisions > 60);
+    assert(mcts->decisionCount() == agent->decisions);
+
+    std::cout << GREEN << "MCTS agent test passed\n\n" << RESET;
+}
+
+// Usługa symulacyjna: parsowanie żądań, pamięć podręczna i warianty zasad.
+void simulationDaemonTest() {
+    std::cout << RESET << "Simulation daemon test running\n" << RESET;
+
+    SimulationDaemon daemon(2, 16, "");
+    std::string const request = "players=Messi,Ronaldo rounds=30 games=200 seed=5";
+    std::string const computed = daemon.handle(request);
+    std::string const cached = daemon.handle("  seed=5 games=200   players=Messi,Ronaldo rounds=30");
+    std::string const threeDice = daemon.handle(request + " rules=threeDice");
+    std::string const expected = daemon_protocol::format(ShardedSimulation({"Messi", "Ronaldo"}, 30).run(5, 200, 1), 2);
+
+    std::cerr << RED;
+    // Kolejność i odstępy nie zmieniają klucza, a wynik jest taki sam jak
+    // z ShardedSimulation dla tych samych ziaren.
+    assert(computed == "ok cached=0 " + expected);
+    assert(cached == "ok cached=1 " + expected);
+    assert(threeDice.rfind("ok cached=0 games=200 ", 0) == 0);
+    assert(daemon.handle(request + " rules=threeDice") == "ok cached=1 " + threeDice.substr(12));
+    assert(daemon.handle(request + " rules=standard") == cached);
+
+    std::vector<std::string> const badRequests = {"players=Messi,Ronaldo games=dużo", "players=Messi colour=red",
+                                                  "rules=cheating", "dice=0", "dice=1/-1", "dice=0/0", "players",
+                                                  "players=" + std::string(12, ',')};
+    for (std::string const &bad : badRequests) {
+        assert(daemon.handle(bad) == "error bad request");
+    }
+
+    // Klucz odróżnia wagi różniące się dopiero na dalekich miejscach
+    // i zapisuje zasady tylko, gdy nie są standardowe.
+    daemon_protocol::Request const fair = daemon_protocol::parse("dice=1/1/1/1/1/1");
+    daemon_protocol::Request const loaded = daemon_protocol::parse("dice=1/1/1/1/1/1.0000001");
+    assert(fair.canonical() != loaded.canonical());
+    assert(fair.canonical().find("dice=1/1/1/1/1/1 ") != std::string::npos);
+    assert(fair.canonical().find("rules=") == std::string::npos);
+    assert(daemon_protocol::parse("rules=strictBookmaker").canonical().find(" rules=strictBookmaker ") !=
+           std::string::npos);
+
+    // Plik pamięci podręcznej jest zapisywany na nowo, gdy dopisanych wpisów
+    // jest ponad dwa razy więcej niż pojemność, a po wczytaniu zostają
+    // ostatnio użyte wpisy.
+    std::string const cachePath = (std::filesystem::temp_directory_path() /
+                                   ("worldcup_cache_" + std::to_string(::getpid()))).string();
+    auto fileLines = [&cachePath] {
+        std::ifstream in(cachePath);
+        return static_cast<std::size_t>(std::count(std::istreambuf_iterator<char>(in),
+                                                   std::istreambuf_iterator<char>(), '\n'));
+    };
+    {
+        ResultCache results(3, cachePath);
+        for (unsigned int k = 0; k < 50; k++) {
+            results.put("key" + std::to_string(k), std::to_string(k));
+            assert(fileLines() <= 3 + 2 * 3);
+        }
+    }
+    {
+        ResultCache results(3, cachePath);
+        std::string value;
+        assert(fileLines() == 3);
+        assert(!results.get("key46", value));
+        for (unsigned int k = 47; k < 50; k++) {
+            assert(results.get("key" + std::to_string(k), value) && value == std::to_string(k));
+        }
+    }
+    std::filesystem::remove(cachePath);
+
+    // Rozgrzane silniki: najwyżej tyle, ile pojemność, i ten sam silnik dla
+    // ostatnio używanych kostek.
+    WarmEngines<DefaultRules> engines(2);
+    WarmEngine<DefaultRules> &six = engines.get({fairDieWeights(6), fairDieWeights(6)});
+    engines.get({fairDieWeights(4), fairDieWeights(6)});
+    assert(&engines.get({fairDieWeights(6), fairDieWeights(6)}) == &six && six.dice.size() == 2);
+    for (unsigned short sides = 2; sides < 20; sides++) {
+        engines.get({fairDieWeights(sides), fairDieWeights(6)});
+        assert(engines.size() <= 2);
+    }
+
+    // To samo przez gniazdo, w wielu kolejnych połączeniach.
+    std::string const socketPath = (std::filesystem::temp_directory_path() /
+                                    ("worldcup_daemon_" + std::to_string(::getpid()))).string();
+    std::thread server([&daemon, &socketPath] { daemon.serve(socketPath); });
+    std::string response;
+    while (response.empty()) {
+        try {
+            response = queryDaemon(socketPath, request);
+        } catch (SimulationDaemon::SocketException &e) {
+            std::this_thread::yield();
+        }
+    }
+    assert(response == cached);
+    for (unsigned int query = 0; query < 20; query++) {
+        assert(queryDaemon(socketPath, request) == cached);
+    }
+    daemon.stop();
+    server.join();
+
+    std::cout << GREEN << "Simulation daemon test passed\n\n" << RESET;
+}
+
+// Sprawdza częstości odwiedzin pól z VisitSolver na domyślnej planszy
+// (12 pól, żółta kartka na polu 4 z czekaniem 2 tur) z wartościami
+// policzonymi ręcznie.
+void markovSolverTest() {
+    std::cout << RESET << "Markov solver test running\n" << RESET;
+
+    std::cerr << RED;
+    auto near = [](double a, double b) {
+        return std::abs(a - b) < 1e-12;
+    };
+    std::vector<SquareSpec> const layout = WorldCup2022().boardLayout();
+    assert(layout.size() == 12 && layout[4].kind == SquareSpec::yellowCard && layout[4].amount == 3);
+
+    // Dwie kostki sześcienne: nwd(12, 2..12) = 1, więc każde pole jest
+    // osiągalne i zatrzymanie ma w ruchu prawdopodobieństwo 1/12. Ruch trwa
+    // średnio 1 + 2/12 = 7/6 tury, a przez pola przechodzi się średnio
+    // E[rzut] - 1 = 6 razy na ruch.
+    VisitFrequencies const fair = VisitSolver(layout, sumDistribution({fairDieWeights(6),
+                                                                        fairDieWeights(6)})).solve();
+    assert(near(fair.turnsPerMove, 7.0 / 6.0));
+    double occupancy = 0.0;
+    double money = 0.0;
+    for (unsigned int s = 0; s < layout.size(); s++) {
+        assert(near(fair.squares[s].stop, 1.0 / 14.0));
+        assert(near(fair.squares[s].pass, 3.0 / 7.0));
+        assert(near(fair.squares[s].occupancy, s == 4 ? 3.0 / 14.0 : 1.0 / 14.0));
+        occupancy += fair.squares[s].occupancy;
+        money += fair.squares[s].money;
+    }
+    assert(near(occupancy, 1.0));
+    assert(near(money, fair.moneyPerTurn));
+
+    // Zawsze 2 oczka: nwd(12, 2) = 2, więc gracz staje tylko na polach
+    // parzystych (każde w co szóstym ruchu) i przechodzi tylko przez
+    // nieparzyste. Żółta kartka jest osiągalna, więc ruch trwa 4/3 tury.
+    VisitFrequencies const two = VisitSolver(layout, {0.0, 0.0, 1.0}).solve();
+    assert(near(two.turnsPerMove, 4.0 / 3.0));
+    occupancy = 0.0;
+    for (unsigned int s = 0; s < layout.size(); s++) {
+        bool const even = s % 2 == 0;
+        assert(near(two.squares[s].stop, even ? 1.0 / 8.0 : 0.0));
+        assert(near(two.squares[s].pass, even ? 0.0 : 1.0 / 8.0));
+        assert(near(two.squares[s].occupancy, s == 4 ? 3.0 / 8.0 : even ? 1.0 / 8.0 : 0.0));
+        occupancy += two.squares[s].occupancy;
+    }
+    assert(near(occupancy, 1.0));
+
+    // Plansza 6 pól i rzuty 3 albo 6: okres 3, gracz stoi na polach 0 i 3.
+    // Pole startowe wypłaca 50 przy zatrzymaniu i przy przejściu, a rzut 6
+    // zawsze przez nie przechodzi albo na nim staje.
+    std::vector<SquareSpec> ring(6);
+    ring[0] = {SquareSpec::seasonBeginning, "Start", 50};
+    for (unsigned int s = 1; s < ring.size(); s++) {
+        ring[s] = {SquareSpec::freeDay, "Wolne"};
+    }
+    VisitFrequencies const periodic = VisitSolver(ring, {0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 1.0}).solve();
+    assert(near(periodic.turnsPerMove, 1.0));
+    for (unsigned int s = 0; s < ring.size(); s++) {
+        assert(near(periodic.squares[s].stop, s % 3 == 0 ? 0.5 : 0.0));
+    }
+    assert(near(periodic.squares[0].pass, 0.25));
+    assert(near(periodic.squares[1].pass, 0.75));
+    assert(near(periodic.squares[3].pass, 0.25));
+    assert(near(periodic.moneyPerTurn, 50.0 * 0.75));
+
+    bool thrown = false;
+    try {
+        VisitSolver(layout, {0.0, -1.0, 2.0});
+    } catch (VisitSolver::InvalidDistributionException &e) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << GREEN << "Markov solver test passed\n\n" << RESET;
+}
 
 #endif
\ No newline at end of file
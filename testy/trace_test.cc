@@ -0,0 +1,98 @@
+// Test śledzenia czasu wykonania (worldcup_trace.h). Kompilowany z
+// WORLDCUP_TRACING razem z silnikiem, więc odcinki są nagrywane także
+// w metodach z worldcup2022_impl.h.
+
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+#include "worldcup2022.h"
+#include "worldcup_random_dice.h"
+#include "scoreboard.h"
+
+std::string const RED = "\033[1;31m";
+std::string const GREEN = "\033[1;32m";
+std::string const CYAN = "\033[1;36m";
+std::string const RESET = "\033[0m";
+
+struct Span {
+    std::string name;
+    unsigned int thread;
+    double begin;
+    double duration;
+};
+
+// Gra na uczciwych kostkach, zrzut do pliku i sprawdzenie odcinków: nazwy,
+// nieujemne początki i zagnieżdżenie wszystkich odcinków wątku w "play".
+void traceDumpTest() {
+    std::cout << RESET << "Trace dump test running\n" << RESET;
+
+    WorldCup2022 worldCup2022;
+    worldCup2022.addDie(std::make_shared<RandomDie>(fairDieWeights(6), 1));
+    worldCup2022.addDie(std::make_shared<RandomDie>(fairDieWeights(6), 2));
+    worldCup2022.addPlayer("Bitek");
+    worldCup2022.addPlayer("Bajtek");
+    worldCup2022.addPlayer("Bolek");
+    worldCup2022.setScoreBoard(std::make_shared<TextScoreBoard>());
+    worldCup2022.play(20);
+
+    std::string const path = (std::filesystem::temp_directory_path() / "worldcup_trace_test.json").string();
+    trace::dump(path);
+    std::ifstream in(path);
+    std::regex const event(R"re(\{"name":"(\w+)","ph":"X","pid":1,"tid":(\d+),"ts":(-?[\d.]+),"dur":(-?[\d.]+)\})re");
+    std::vector<Span> spans;
+    std::string line;
+    std::getline(in, line);
+    std::cerr << RED;
+    assert(line == "{\"traceEvents\":[");
+    while (std::getline(in, line) && line != "]}") {
+        std::smatch match;
+        assert(std::regex_search(line, match, event));
+        spans.push_back({match[1], static_cast<unsigned int>(std::stoul(match[2])),
+                         std::stod(match[3]), std::stod(match[4])});
+    }
+    assert(line == "]}");
+    std::filesystem::remove(path);
+
+    std::map<std::string, unsigned int> counts;
+    std::map<unsigned int, const Span *> play;
+    for (const Span &span : spans) {
+        counts[span.name]++;
+        assert(span.begin >= 0.0 && span.duration >= 0.0);
+        if (span.name == "play") {
+            play[span.thread] = &span;
+        }
+    }
+    for (const char *name : {"play", "round", "onRound", "roll", "movePlayer", "onTurn", "onWin"}) {
+        assert(counts[name] > 0);
+    }
+    assert(counts["play"] == 1 && counts["onWin"] == 1 && counts["round"] == counts["onRound"]);
+    assert(counts["roll"] == counts["movePlayer"]);
+
+    // Czasy są zapisane z dokładnością do 0,001 us.
+    double const rounding = 0.002;
+    for (const Span &span : spans) {
+        const Span &outer = *play.at(span.thread);
+        assert(span.begin + rounding >= outer.begin);
+        assert(span.begin + span.duration <= outer.begin + outer.duration + rounding);
+    }
+
+    trace::clear();
+    trace::dump(path);
+    std::ifstream empty(path);
+    std::string contents((std::istreambuf_iterator<char>(empty)), std::istreambuf_iterator<char>());
+    assert(contents == "{\"traceEvents\":[\n]}\n");
+    std::filesystem::remove(path);
+
+    std::cout << GREEN << "Trace dump test passed\n\n" << RESET;
+}
+
+int main() {
+    traceDumpTest();
+    std::cout << CYAN << "All tests passed succesfully\n" << RESET;
+}
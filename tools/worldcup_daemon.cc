@@ -0,0 +1,43 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../worldcup_daemon.h"
+
+// Uruchamia usługę symulacyjną:
+//   worldcup_daemon <gniazdo> [plik-pamięci-podręcznej] [wątki] [pojemność]
+// Zapytanie bez uruchamiania usługi:
+//   worldcup_daemon --query <gniazdo> "<żądanie>"
+
+namespace {
+    SimulationDaemon *running = nullptr;
+
+    void onSignal(int) {
+        if (running != nullptr) {
+            running->stop();
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 4 && std::string(argv[1]) == "--query") {
+        std::cout << queryDaemon(argv[2], argv[3]) << "\n";
+        return 0;
+    }
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <socket> [cache-file] [threads] [capacity]\n"
+                  << "       " << argv[0] << " --query <socket> \"<request>\"\n";
+        return 1;
+    }
+    std::string cachePath = argc > 2 ? argv[2] : "";
+    unsigned int threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    std::size_t capacity = argc > 4 ? std::stoull(argv[4]) : 4096;
+
+    SimulationDaemon daemon(threads, capacity, cachePath);
+    running = &daemon;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    daemon.serve(argv[1]);
+    return 0;
+}
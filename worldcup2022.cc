@@ -0,0 +1,10 @@
+// Jawne konkretyzacje wbudowanych wariantów zasad, kompilowane raz
+// w bibliotece zamiast w każdej jednostce dołączającej worldcup2022.h
+// (zob. worldcup2022_impl.h). Gorące ścieżki (ruch gracza, akcje pól, rzuty)
+// pozostają w nagłówku i są tu rozwijane w play().
+
+#include "worldcup2022.h"
+
+template class BasicWorldCup<DefaultRules>;
+template class BasicWorldCup<ThreeDiceRules>;
+template class BasicWorldCup<StrictBookmakerRules>;
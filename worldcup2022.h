@@ -1,40 +1,131 @@
 #ifndef WORLDCUP2022_H
 #define WORLDCUP2022_H
 
+#include <exception>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 #include <list>
-#include <iostream>
+#include <set>
 #include <cassert>
 
 #include "worldcup.h"
+#include "worldcup_dice.h"
+#include "worldcup_plugin.h"
+#include "worldcup_trace.h"
+
+// Zasady gry jako typ-polityka silnika. Każdy wariant zasad dostaje własną
+// instancję BasicWorldCup ze stałymi wstawionymi w czasie kompilacji.
+struct DefaultRules {
+    static constexpr unsigned int startingBalance = 1000;
+    static constexpr unsigned int minPlayers = 2;
+    static constexpr unsigned int maxPlayers = 11;
+    static constexpr unsigned int leagueMaxPlayers = 100000;
+    static constexpr unsigned int diesNumber = 2;
+    static constexpr unsigned int startBonus = 50;
+    static constexpr unsigned int bookmakerWinFrequency = 3;
+};
+
+// Zasady domowe: gra trzema kostkami.
+struct ThreeDiceRules : DefaultRules {
+    static constexpr unsigned int diesNumber = 3;
+};
+
+// Zasady domowe: bukmacher wygrywa z czterema graczami na pięciu.
+struct StrictBookmakerRules : DefaultRules {
+    static constexpr unsigned int bookmakerWinFrequency = 5;
+};
+
+// Odbiera migawki stanu gry na koniec każdej rundy (np. do eksportu danych
+// analitycznych). W odróżnieniu od ScoreBoard dostaje surowe liczby zamiast
+// sformatowanych napisów.
+class RoundRecorder {
+public:
+    virtual ~RoundRecorder() = default;
+
+    // Wywoływane na początku każdej rozgrywki.
+    virtual void onGameStart() = 0;
+
+    // Wywoływane dla każdego gracza pozostającego w grze.
+    virtual void onPlayerState(unsigned int roundNo, unsigned int playerId, unsigned int position,
+                               unsigned int money, unsigned int suspension) = 0;
+
+    // Wywoływane dla każdego pola gromadzącego pulę (mecze).
+    virtual void onPot(unsigned int roundNo, unsigned int square, unsigned int pot) = 0;
+};
+
+// Opis pola planszy w postaci danych, niezależny od klas pól silnika
+// (np. dla szybkich symulatorów i solwerów). Znaczenie amount zależy od
+// rodzaju pola: premia, cena obrony, stawka zakładu, długość kary albo
+// opłata za mecz.
+struct SquareSpec {
+    enum Kind {seasonBeginning, goal, penalty, bookmaker, yellowCard, match, freeDay, custom};
+
+    Kind kind = custom;
+    std::string name;
+    unsigned int amount = 0;
+    // Waga meczu.
+    float rate = 0;
+    // Co który gracz wygrywa u bukmachera.
+    unsigned int frequency = 0;
+};
+
+// Stan rozgrywki w chwili decyzji gracza. Wektory graczy są w kolejności
+// ruchów i obejmują tylko graczy pozostających w grze; fieldState to pula
+// meczu albo licznik serii bukmachera (0 dla pozostałych pól).
+struct GameSnapshot {
+    std::vector<unsigned int> ids;
+    std::vector<unsigned int> positions;
+    std::vector<unsigned int> money;
+    std::vector<unsigned int> suspensions;
+    std::vector<unsigned int> fieldState;
+    unsigned int current = 0;
+    unsigned int round = 0;
+    unsigned int rounds = 0;
+};
+
+// Decyduje za gracza, czy w tej turze zamiast rzucać kostkami odpuszcza ruch
+// (zostaje na swoim polu i nie wykonuje żadnej akcji). Gracze bez agenta
+// zawsze rzucają, zgodnie z podstawowymi zasadami.
+class TurnAgent {
+public:
+    virtual ~TurnAgent() = default;
 
-#define STARTING_BALANCE 1000
-#define MIN_PLAYERS 2
-#define MAX_PLAYERS 11
-#define DIES_NUMBER 2
-#define START_BONUS 50
-#define BOOKMAKER_WIN_FREQUENCY 3
+    virtual bool sitOut(const GameSnapshot &snapshot) = 0;
+};
 
-class WorldCup2022 : public WorldCup {
+// Rzadko wykonywane metody (konstruktor, kontrole, play()) są zdefiniowane
+// w worldcup2022_impl.h, więc silnik działa z dowolnymi zasadami (np. struktura
+// dziedzicząca po DefaultRules z inną premią startową). Warianty z RuleVariant
+// są jawnie konkretyzowane w worldcup2022.cc, który trzeba skompilować razem
+// z programem; nowy wariant trzeba dopisać tam i w extern template poniżej.
+template<typename Rules>
+class BasicWorldCup : public WorldCup {
 private:
     class Player {
     private:
         const std::string name;
+        const unsigned int id;
         unsigned int position = 0;
-        unsigned int zdzislaws = STARTING_BALANCE;
+        unsigned int zdzislaws = Rules::startingBalance;
         bool isBankrupt = false;
     public:
         int suspension = 0;
+        const std::shared_ptr<TurnAgent> agent;
 
-        explicit Player(std::string name) : name(std::move(name)) {}
+        Player(std::string name, unsigned int id, std::shared_ptr<TurnAgent> agent = nullptr) :
+               name(std::move(name)), id(id), agent(std::move(agent)) {}
 
-        std::string getName() {
+        [[nodiscard]] const std::string &getName() const {
             return name;
         }
 
+        [[nodiscard]] unsigned int getId() const {
+            return id;
+        }
+
         void move(unsigned int fields, unsigned int boardSize) {
             position = (position + fields) % boardSize;
         }
@@ -70,6 +161,10 @@ private:
         void putToStart() {
             this->position = 0;
         }
+
+        FieldPlayer view() {
+            return {zdzislaws, suspension, isBankrupt};
+        }
     };
 
     class Field {
@@ -87,6 +182,18 @@ private:
         virtual void onPlayerStop([[maybe_unused]] Player &player) {}
         virtual void onPlayerPass([[maybe_unused]] Player &player) {}
         virtual void reset() {}
+
+        [[nodiscard]] virtual std::optional<unsigned int> pot() const {
+            return std::nullopt;
+        }
+
+        [[nodiscard]] virtual unsigned int state() const {
+            return 0;
+        }
+
+        [[nodiscard]] virtual SquareSpec spec() const {
+            return {SquareSpec::custom, name};
+        }
     };
 
     class SeasonBeginning : public Field {
@@ -94,11 +201,18 @@ private:
         explicit SeasonBeginning(std::string const &name) : Field(name) {}
 
         void onPlayerStop(Player &player) override {
-            player.addMoney(START_BONUS);
+            player.addMoney(Rules::startBonus);
         }
 
         void onPlayerPass(Player &player) override {
-            player.addMoney(START_BONUS);
+            player.addMoney(Rules::startBonus);
+        }
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::seasonBeginning;
+            s.amount = Rules::startBonus;
+            return s;
         }
     };
 
@@ -112,6 +226,13 @@ private:
         void onPlayerStop(Player &player) override {
             player.addMoney(bonus);
         }
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::goal;
+            s.amount = bonus;
+            return s;
+        }
     };
 
     class Penalty : public Field {
@@ -124,6 +245,13 @@ private:
         void onPlayerStop(Player &player) override {
             player.substractMoney(savePrice);
         }
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::penalty;
+            s.amount = savePrice;
+            return s;
+        }
     };
 
     class Bookmaker : public Field {
@@ -140,12 +268,24 @@ private:
             } else {
                 player.substractMoney(betSize);
             }
-            playersCount = (playersCount + 1) % BOOKMAKER_WIN_FREQUENCY;
+            playersCount = (playersCount + 1) % Rules::bookmakerWinFrequency;
         }
 
         void reset() override {
             playersCount = 0;
         }
+
+        [[nodiscard]] unsigned int state() const override {
+            return playersCount;
+        }
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::bookmaker;
+            s.amount = betSize;
+            s.frequency = Rules::bookmakerWinFrequency;
+            return s;
+        }
     };
 
     class YellowCard : public Field {
@@ -158,6 +298,13 @@ private:
         void onPlayerStop(Player &player) override {
             player.suspension += suspensionSize - 1;
         }
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::yellowCard;
+            s.amount = suspensionSize;
+            return s;
+        }
     };
 
     class Match : public Field {
@@ -192,6 +339,22 @@ private:
             matchBonus = 0;
         }
 
+        [[nodiscard]] std::optional<unsigned int> pot() const override {
+            return matchBonus;
+        }
+
+        [[nodiscard]] unsigned int state() const override {
+            return matchBonus;
+        }
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::match;
+            s.amount = fee;
+            s.rate = matchRate;
+            return s;
+        }
+
     private:
         const unsigned int fee;
         float matchRate;
@@ -201,6 +364,34 @@ private:
     class FreeDay : public Field {
     public:
         explicit FreeDay(const std::string &name) : Field(name) {}
+
+        [[nodiscard]] SquareSpec spec() const override {
+            SquareSpec s = Field::spec();
+            s.kind = SquareSpec::freeDay;
+            return s;
+        }
+    };
+
+    class PluginField : public Field {
+    private:
+        const std::shared_ptr<FieldPlugin> plugin;
+    public:
+        explicit PluginField(std::shared_ptr<FieldPlugin> plugin) :
+                             Field(plugin->name()), plugin(std::move(plugin)) {}
+
+        void onPlayerStop(Player &player) override {
+            FieldPlayer view = player.view();
+            plugin->onPlayerStop(view);
+        }
+
+        void onPlayerPass(Player &player) override {
+            FieldPlayer view = player.view();
+            plugin->onPlayerPass(view);
+        }
+
+        void reset() override {
+            plugin->reset();
+        }
     };
 
     class Board {
@@ -215,11 +406,11 @@ private:
             }
         }
 
-        [[maybe_unused]] void addField(const std::shared_ptr<Field> &field) {
+        void addField(const std::shared_ptr<Field> &field) {
             fields.push_back(field);
         }
 
-        unsigned int size() {
+        [[nodiscard]] unsigned int size() const {
             return fields.size();
         }
 
@@ -229,28 +420,55 @@ private:
         }
 
         void resetBoard() {
-            for (std::shared_ptr<Field> f : fields) {
-                f.reset();
+            for (const std::shared_ptr<Field> &f : fields) {
+                f->reset();
             }
         }
     };
 
+    // Jeśli wszystkie kostki mają znany rozkład (DistributionDie), prepare()
+    // wylicza rozkład sumy i roll() losuje go tablicą aliasów jednym
+    // losowaniem z generatora pierwszej kostki, niezależnie od liczby kostek.
+    // W przeciwnym razie rzuca się każdą kostką osobno.
     class Dies {
     private:
         std::vector<std::shared_ptr<Die>> dies;
+        AliasTable sumTable;
+        const DistributionDie *source = nullptr;
 
     public:
         Dies() = default;
 
         [[maybe_unused]] void addDie(const std::shared_ptr<Die> &die) {
             dies.push_back(die);
+            source = nullptr;
         }
 
         unsigned int size() {
             return dies.size();
         }
 
+        void prepare() {
+            source = nullptr;
+            std::vector<std::vector<double>> distributions;
+            for (auto &&die : dies) {
+                auto known = dynamic_cast<const DistributionDie *>(die.get());
+                if (known == nullptr) {
+                    return;
+                }
+                distributions.push_back(known->faceWeights());
+            }
+            if (dies.empty()) {
+                return;
+            }
+            sumTable = AliasTable(sumDistribution(distributions));
+            source = dynamic_cast<const DistributionDie *>(dies.front().get());
+        }
+
         unsigned int roll() {
+            if (source != nullptr) {
+                return sumTable.sample(source->nextRandom());
+            }
             unsigned int sum = 0;
             for (auto &&die : dies) {
                 sum += die->roll();
@@ -259,6 +477,66 @@ private:
         }
     };
 
+    // Ranking graczy utrzymywany przyrostowo: po każdej turze aktualizowany jest
+    // tylko wpis gracza, który się ruszał (akcje pól dotyczą wyłącznie jego),
+    // więc koszt tury to O(log n) niezależnie od liczby graczy, a zwycięzca
+    // i czołówka są dostępne bez przeglądania wszystkich graczy.
+    class Standings {
+    private:
+        struct Entry {
+            unsigned int money;
+            unsigned int id;
+            const Player *player;
+        };
+
+        // Remisy rozstrzygane są kolejnością dodania, tak jak w findWinner().
+        struct Better {
+            bool operator()(const Entry &a, const Entry &b) const {
+                if (a.money != b.money) {
+                    return a.money > b.money;
+                }
+                return a.id < b.id;
+            }
+        };
+
+        std::set<Entry, Better> entries;
+
+    public:
+        void clear() {
+            entries.clear();
+        }
+
+        void add(const Player &player) {
+            entries.insert({player.getMoney(), player.getId(), &player});
+        }
+
+        void update(const Player &player, unsigned int oldMoney) {
+            if (oldMoney == player.getMoney()) {
+                return;
+            }
+            auto node = entries.extract({oldMoney, player.getId(), nullptr});
+            assert(!node.empty());
+            node.value().money = player.getMoney();
+            entries.insert(std::move(node));
+        }
+
+        void remove(const Player &player, unsigned int oldMoney) {
+            entries.erase({oldMoney, player.getId(), nullptr});
+        }
+
+        [[nodiscard]] const Player *leader() const {
+            return entries.empty() ? nullptr : entries.begin()->player;
+        }
+
+        [[nodiscard]] std::vector<std::pair<std::string, unsigned int>> top(unsigned int k) const {
+            std::vector<std::pair<std::string, unsigned int>> result;
+            for (auto it = entries.begin(); it != entries.end() && result.size() < k; it++) {
+                result.emplace_back(it->player->getName(), it->money);
+            }
+            return result;
+        }
+    };
+
     class DefaultScoreboard : public ScoreBoard {
     public:
         void onRound([[maybe_unused]] unsigned int roundNo) override {}
@@ -274,55 +552,34 @@ private:
     Dies dies;
     std::list<Player> players;
     std::shared_ptr<ScoreBoard> scoreboard = std::make_shared<DefaultScoreboard>();
+    std::shared_ptr<RoundRecorder> recorder;
     Board board;
+    Standings standings;
+    unsigned int maxPlayers = Rules::maxPlayers;
+    // Numery graczy nie są używane ponownie, bo bankruci znikają z listy
+    // i players.size() mógłby powtórzyć numer gracza pozostającego w grze.
+    unsigned int nextId = 0;
 
     class TooManyDiceException : public std::exception {};
     class TooFewDiceException : public std::exception {};
     class TooManyPlayersException : public std::exception {};
     class TooFewPlayersException : public std::exception {};
 
-    void checkDies() {
-        if (dies.size() > DIES_NUMBER) {
-            throw TooManyDiceException();
-        }
-        if (dies.size() < DIES_NUMBER) {
-            throw TooFewDiceException();
-        }
-    }
-
-    void checkPlayers() {
-        if (players.size() > MAX_PLAYERS) {
-            throw TooManyPlayersException();
-        }
-        if (players.size() < MIN_PLAYERS) {
-            throw TooFewPlayersException();
-        }
-    }
-
-    void makeBoard() {
-        this->board = Board({
-            std::make_shared<SeasonBeginning>("Początek sezonu"),
-            std::make_shared<Match>("Mecz z San Marino", Match::friendly, 160),
-            std::make_shared<FreeDay>("Dzień wolny od treningu"),
-            std::make_shared<Match>("Mecz z Lichtensteinem", Match::friendly, 220),
-            std::make_shared<YellowCard>("Żółta kartka", 3),
-            std::make_shared<Match>("Mecz z Meksykiem", Match::forPoints, 300),
-            std::make_shared<Match>("Mecz z Arabią Saudyjską", Match::forPoints, 280),
-            std::make_shared<Bookmaker>("Bukmacher", 100),
-            std::make_shared<Match>("Mecz z Argentyną", Match::forPoints, 250),
-            std::make_shared<Goal>("Gol", 120),
-            std::make_shared<Match>("Mecz z Francją", Match::final, 400),
-            std::make_shared<Penalty>("Rzut karny", 180)
-        });
-    }
+    // Zdefiniowane w worldcup2022_impl.h.
+    void checkDies();
+    void checkPlayers();
+    void makeBoard();
 
     std::string movePlayer(Player *player, unsigned int fields) {
+        WORLDCUP_TRACE_SCOPE("movePlayer");
         unsigned int position = player->getPosition();
         for (unsigned int i = 1; i < fields && !player->bankrupt(); i++) {
+            WORLDCUP_TRACE_SCOPE("onPlayerPass");
             board.getField((position + i) % board.size())->onPlayerPass(*player);
         }
         player->move(fields, board.size());
         if(!player->bankrupt()) {
+            WORLDCUP_TRACE_SCOPE("onPlayerStop");
             board.getField(player->getPosition())->onPlayerStop(*player);
         }
         if (player->bankrupt()) {
@@ -334,73 +591,117 @@ private:
         return "w grze";
     }
 
-    std::string findWinner() {
-        if (players.size() == 1) {
-            return players.front().getName();
-        } 
-        unsigned int max_money = 0;
-        std::string winnerName;
-        for (Player p : players) {
-            if (p.getMoney() > max_money) {
-                max_money = p.getMoney();
-                winnerName = p.getName();
-            }
-        }
-        return winnerName;
-    }
+    void recordRound(unsigned int round);
+    GameSnapshot snapshot(const Player &current, unsigned int round, unsigned int rounds) const;
+    std::string findWinner();
+    void resetStandings();
 
 public:
-    WorldCup2022() {
-        makeBoard();
-    }
+    BasicWorldCup();
 
     void addDie(std::shared_ptr<Die> die) override {
         if (die != nullptr) dies.addDie(die);
     }
 
     void addPlayer(std::string const &name) override {
-        players.emplace_back(name);
+        players.emplace_back(name, nextId++);
+    }
+
+    // Dodaje gracza, za którego decyzje o odpuszczeniu tury podejmuje agent.
+    void addPlayer(std::string const &name, std::shared_ptr<TurnAgent> agent) {
+        players.emplace_back(name, nextId++, std::move(agent));
+    }
+
+    // Układ planszy w postaci danych.
+    [[nodiscard]] std::vector<SquareSpec> boardLayout() const;
+
+    // Dopisuje na końcu planszy pole z wtyczki (zob. FieldPluginLibrary
+    // w worldcup_plugin_library.h). W układzie planszy jest ono polem typu custom.
+    void addField(std::shared_ptr<FieldPlugin> plugin) {
+        if (plugin != nullptr) board.addField(std::make_shared<PluginField>(std::move(plugin)));
+    }
+
+    // Usuwa wszystkich graczy, dzięki czemu ten sam silnik (z kostkami i tablicą
+    // wyników) może rozegrać kolejną, niezależną rozgrywkę.
+    void removePlayers() {
+        players.clear();
+        standings.clear();
+        nextId = 0;
     }
 
     void setScoreBoard(std::shared_ptr<ScoreBoard> sb) override {
         this->scoreboard = sb;
     }
 
+    // Ustawia odbiorcę migawek stanu po każdej rundzie; pusty wskaźnik
+    // wyłącza nagrywanie.
+    void setRoundRecorder(std::shared_ptr<RoundRecorder> rr) {
+        this->recorder = std::move(rr);
+    }
+
+    // Tryb ligowy podnosi limit graczy z Rules::maxPlayers do Rules::leagueMaxPlayers.
+    void enableLeagueMode() {
+        maxPlayers = Rules::leagueMaxPlayers;
+    }
+
+    // Zwraca co najwyżej k najbogatszych graczy wraz z ich stanem konta.
+    [[nodiscard]] std::vector<std::pair<std::string, unsigned int>> topPlayers(unsigned int k) const {
+        return standings.top(k);
+    }
+
     void resetPlayersPosition() {
-        for (Player p : players) {
+        for (Player &p : players) {
             p.putToStart();
         }
     }
 
-    void play(unsigned int rounds) override {
-        checkDies();
-        checkPlayers();
-        board.resetBoard();
-        resetPlayersPosition();
-        for (unsigned int round = 0; round < rounds && players.size() > 1; round++) {
-            scoreboard->onRound(round);
-            std::string status;
-            for (auto playerIt = players.begin(); playerIt != players.end() && players.size() > 1;) {
-                if (playerIt->suspension > 0) {
-                    status = "*** czekanie: " + std::to_string(playerIt->suspension) + " ***";
-                    playerIt->suspension--;
-                } else {
-                    status = movePlayer(&(*playerIt), dies.roll());
-                }
+    void play(unsigned int rounds) override;
+};
 
-                scoreboard->onTurn(playerIt->getName(), status, board.getField(playerIt->getPosition())->getName(),
-                                   playerIt->getMoney());
+using WorldCup2022 = BasicWorldCup<DefaultRules>;
 
-                if (playerIt->bankrupt()) {
-                    if (players.size() == 1) break;
-                    players.erase(playerIt++);
-                } else {
-                    playerIt++;
-                }
-            }
-        }
-        if (!players.empty()) scoreboard->onWin(findWinner());
+extern template class BasicWorldCup<DefaultRules>;
+extern template class BasicWorldCup<ThreeDiceRules>;
+extern template class BasicWorldCup<StrictBookmakerRules>;
+
+#include "worldcup2022_impl.h"
+
+// Wybór wariantu zasad w czasie działania programu. Rozgałęzienie następuje raz
+// na grę, a sama gra toczy się w pełni wyspecjalizowanym kodzie. Wariant
+// wybierają makeWorldCup, ShardedSimulation, SimulationDaemon i moduł Pythona
+// (rules=); MctsAgent gra według układu planszy podanego silnika, a
+// ImportanceSampler i SequentialEstimator zawsze według DefaultRules.
+enum class RuleVariant {standard, threeDice, strictBookmaker};
+
+// Nazwy wariantów w protokole demona i w module Pythona.
+inline const std::vector<std::pair<std::string, RuleVariant>> &ruleVariantNames() {
+    static const std::vector<std::pair<std::string, RuleVariant>> names = {
+        {"standard", RuleVariant::standard},
+        {"threeDice", RuleVariant::threeDice},
+        {"strictBookmaker", RuleVariant::strictBookmaker}
     };
-};
+    return names;
+}
+
+// Wywołuje f(Rules{}) dla typu zasad wariantu, np.
+//   dispatchRules(v, [&](auto rules) { BasicWorldCup<decltype(rules)> engine; ... });
+template<typename F>
+decltype(auto) dispatchRules(RuleVariant variant, F &&f) {
+    switch (variant) {
+        case RuleVariant::threeDice:
+            return f(ThreeDiceRules{});
+        case RuleVariant::strictBookmaker:
+            return f(StrictBookmakerRules{});
+        case RuleVariant::standard:
+            break;
+    }
+    return f(DefaultRules{});
+}
+
+inline std::unique_ptr<WorldCup> makeWorldCup(RuleVariant variant) {
+    return dispatchRules(variant, [](auto rules) -> std::unique_ptr<WorldCup> {
+        return std::make_unique<BasicWorldCup<decltype(rules)>>();
+    });
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#ifndef WORLDCUP2022_IMPL_H
+#define WORLDCUP2022_IMPL_H
+
+// Definicje rzadko wykonywanych metod BasicWorldCup (budowa planszy, kontrole
+// konfiguracji, przebieg gry na poziomie rund). Dołącza je worldcup2022.h, więc
+// działają z dowolnymi zasadami, ale wbudowane warianty są jawnie
+// konkretyzowane raz w worldcup2022.cc (zob. extern template), a pozostałe
+// jednostki ich nie kompilują.
+
+#include "worldcup2022.h"
+
+template<typename Rules>
+BasicWorldCup<Rules>::BasicWorldCup() {
+    makeBoard();
+}
+
+template<typename Rules>
+void BasicWorldCup<Rules>::checkDies() {
+    if (dies.size() > Rules::diesNumber) {
+        throw TooManyDiceException();
+    }
+    if (dies.size() < Rules::diesNumber) {
+        throw TooFewDiceException();
+    }
+}
+
+template<typename Rules>
+void BasicWorldCup<Rules>::checkPlayers() {
+    if (players.size() > maxPlayers) {
+        throw TooManyPlayersException();
+    }
+    if (players.size() < Rules::minPlayers) {
+        throw TooFewPlayersException();
+    }
+}
+
+template<typename Rules>
+void BasicWorldCup<Rules>::makeBoard() {
+    this->board = Board({
+        std::make_shared<SeasonBeginning>("Początek sezonu"),
+        std::make_shared<Match>("Mecz z San Marino", Match::friendly, 160),
+        std::make_shared<FreeDay>("Dzień wolny od treningu"),
+        std::make_shared<Match>("Mecz z Lichtensteinem", Match::friendly, 220),
+        std::make_shared<YellowCard>("Żółta kartka", 3),
+        std::make_shared<Match>("Mecz z Meksykiem", Match::forPoints, 300),
+        std::make_shared<Match>("Mecz z Arabią Saudyjską", Match::forPoints, 280),
+        std::make_shared<Bookmaker>("Bukmacher", 100),
+        std::make_shared<Match>("Mecz z Argentyną", Match::forPoints, 250),
+        std::make_shared<Goal>("Gol", 120),
+        std::make_shared<Match>("Mecz z Francją", Match::final, 400),
+        std::make_shared<Penalty>("Rzut karny", 180)
+    });
+}
+
+template<typename Rules>
+void BasicWorldCup<Rules>::recordRound(unsigned int round) {
+    for (const Player &p : players) {
+        recorder->onPlayerState(round, p.getId(), p.getPosition(), p.getMoney(), p.suspension);
+    }
+    for (unsigned int square = 0; square < board.size(); square++) {
+        if (auto pot = board.getField(square)->pot()) {
+            recorder->onPot(round, square, *pot);
+        }
+    }
+}
+
+template<typename Rules>
+GameSnapshot BasicWorldCup<Rules>::snapshot(const Player &current, unsigned int round, unsigned int rounds) const {
+    GameSnapshot result;
+    for (const Player &p : players) {
+        if (&p == &current) {
+            result.current = result.ids.size();
+        }
+        result.ids.push_back(p.getId());
+        result.positions.push_back(p.getPosition());
+        result.money.push_back(p.getMoney());
+        result.suspensions.push_back(p.suspension);
+    }
+    for (unsigned int square = 0; square < board.size(); square++) {
+        result.fieldState.push_back(board.getField(square)->state());
+    }
+    result.round = round;
+    result.rounds = rounds;
+    return result;
+}
+
+template<typename Rules>
+std::string BasicWorldCup<Rules>::findWinner() {
+    if (players.size() == 1) {
+        return players.front().getName();
+    }
+    const Player *leader = standings.leader();
+    if (leader == nullptr || leader->getMoney() == 0) {
+        return "";
+    }
+    return leader->getName();
+}
+
+template<typename Rules>
+void BasicWorldCup<Rules>::resetStandings() {
+    standings.clear();
+    for (const Player &p : players) {
+        standings.add(p);
+    }
+}
+
+template<typename Rules>
+std::vector<SquareSpec> BasicWorldCup<Rules>::boardLayout() const {
+    std::vector<SquareSpec> layout;
+    for (unsigned int i = 0; i < board.size(); i++) {
+        layout.push_back(board.getField(i)->spec());
+    }
+    return layout;
+}
+
+template<typename Rules>
+void BasicWorldCup<Rules>::play(unsigned int rounds) {
+    WORLDCUP_TRACE_SCOPE("play");
+    checkDies();
+    checkPlayers();
+    dies.prepare();
+    board.resetBoard();
+    resetPlayersPosition();
+    resetStandings();
+    if (recorder) recorder->onGameStart();
+    for (unsigned int round = 0; round < rounds && players.size() > 1; round++) {
+        WORLDCUP_TRACE_SCOPE("round");
+        {
+            WORLDCUP_TRACE_SCOPE("onRound");
+            scoreboard->onRound(round);
+        }
+        std::string status;
+        for (auto playerIt = players.begin(); playerIt != players.end() && players.size() > 1;) {
+            unsigned int oldMoney = playerIt->getMoney();
+            if (playerIt->suspension > 0) {
+                status = "*** czekanie: " + std::to_string(playerIt->suspension) + " ***";
+                playerIt->suspension--;
+            } else if (playerIt->agent && playerIt->agent->sitOut(snapshot(*playerIt, round, rounds))) {
+                status = "w grze";
+            } else {
+                unsigned int fields;
+                {
+                    WORLDCUP_TRACE_SCOPE("roll");
+                    fields = dies.roll();
+                }
+                status = movePlayer(&(*playerIt), fields);
+            }
+
+            {
+                WORLDCUP_TRACE_SCOPE("onTurn");
+                scoreboard->onTurn(playerIt->getName(), status,
+                                   board.getField(playerIt->getPosition())->getName(), playerIt->getMoney());
+            }
+
+            if (playerIt->bankrupt()) {
+                if (players.size() == 1) break;
+                WORLDCUP_TRACE_SCOPE("bankruptcy");
+                standings.remove(*playerIt, oldMoney);
+                players.erase(playerIt++);
+            } else {
+                standings.update(*playerIt, oldMoney);
+                playerIt++;
+            }
+        }
+        if (recorder) recordRound(round);
+    }
+    if (!players.empty()) {
+        WORLDCUP_TRACE_SCOPE("onWin");
+        scoreboard->onWin(findWinner());
+    }
+}
+
+#endif
@@ -0,0 +1,564 @@
+#ifndef WORLDCUP_DAEMON_H
+#define WORLDCUP_DAEMON_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "worldcup_shards.h"
+
+// Lokalna usługa symulacyjna dostępna przez gniazdo uniksowe.
+//
+// Protokół: jedno żądanie w linii, pary klucz=wartość oddzielone spacjami:
+//   players=Messi,Ronaldo rounds=100 games=10000 seed=0 dice=6,6 rules=standard
+// dice to liczby ścian uczciwych kostek albo wagi ścian od 1 oddzielone
+// ukośnikami (np. 1/1/1/1/1/3); domyślnie tyle kostek sześciościennych, ile
+// wymagają zasady. rules to standard, threeDice albo strictBookmaker
+// (zob. ruleVariantNames()). Odpowiedź to jedna linia:
+//   ok cached=0 games=10000 rounds=... nowinner=... wins=...,...
+// albo "error <opis>".
+//
+// Wyniki są zapamiętywane w pamięci (LRU) pod kanoniczną postacią żądania
+// i dopisywane do pliku, z którego są wczytywane przy starcie, więc
+// powtórzone zapytanie nie wymaga ponownej symulacji. Gra numer g używa kostek
+// zasianych z seed + g, więc wynik nie zależy od podziału pracy na wątki.
+namespace daemon_protocol {
+
+    class BadRequestException : public std::exception {};
+
+    struct Request {
+        std::vector<std::string> players;
+        std::vector<std::vector<double>> dice;
+        unsigned int rounds = 100;
+        std::uint64_t games = 1000;
+        std::uint64_t seed = 0;
+        RuleVariant rules = RuleVariant::standard;
+
+        // Postać kanoniczna: ustalona kolejność pól i znormalizowane liczby.
+        // Wagi są zapisywane z 17 cyframi znaczącymi, więc różne wagi dają
+        // różne klucze (a całkowite wyglądają tak jak wcześniej).
+        [[nodiscard]] std::string canonical() const {
+            std::ostringstream out;
+            out << std::setprecision(17) << "board=2022 dice=";
+            for (std::size_t d = 0; d < dice.size(); d++) {
+                out << (d ? "," : "");
+                for (std::size_t k = 1; k < dice[d].size(); k++) {
+                    out << (k > 1 ? "/" : "") << dice[d][k];
+                }
+            }
+            out << " games=" << games << " players=";
+            for (std::size_t p = 0; p < players.size(); p++) {
+                out << (p ? "," : "") << players[p];
+            }
+            out << " rounds=" << rounds;
+            // Standardowe zasady nie są zapisywane, żeby zachować klucze
+            // zapamiętane przed wprowadzeniem wariantów.
+            for (const auto &[name, variant] : ruleVariantNames()) {
+                if (variant == rules && rules != RuleVariant::standard) {
+                    out << " rules=" << name;
+                }
+            }
+            out << " seed=" << seed;
+            return out.str();
+        }
+    };
+
+    inline std::vector<std::string> split(const std::string &text, char separator) {
+        std::vector<std::string> parts;
+        std::string part;
+        std::istringstream in(text);
+        while (std::getline(in, part, separator)) {
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    inline std::uint64_t number(const std::string &text) {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+            throw BadRequestException();
+        }
+        return std::stoull(text);
+    }
+
+    inline std::vector<double> parseDie(const std::string &text) {
+        if (text.find('/') == std::string::npos) {
+            std::uint64_t sides = number(text);
+            if (sides == 0 || sides > 1000) {
+                throw BadRequestException();
+            }
+            return fairDieWeights(sides);
+        }
+        std::vector<double> weights = {0.0};
+        double total = 0.0;
+        for (const std::string &weight : split(text, '/')) {
+            std::size_t used = 0;
+            double value = std::stod(weight, &used);
+            if (used != weight.size() || !(value >= 0.0)) {
+                throw BadRequestException();
+            }
+            weights.push_back(value);
+            total += value;
+        }
+        if (!(total > 0.0)) {
+            throw BadRequestException();
+        }
+        return weights;
+    }
+
+    inline Request parse(const std::string &line) {
+        Request request;
+        for (const std::string &token : split(line, ' ')) {
+            if (token.empty()) {
+                continue;
+            }
+            auto eq = token.find('=');
+            if (eq == std::string::npos) {
+                throw BadRequestException();
+            }
+            std::string key = token.substr(0, eq);
+            std::string value = token.substr(eq + 1);
+            try {
+                if (key == "players") {
+                    request.players = split(value, ',');
+                } else if (key == "dice") {
+                    request.dice.clear();
+                    for (const std::string &die : split(value, ',')) {
+                        request.dice.push_back(parseDie(die));
+                    }
+                } else if (key == "rounds") {
+                    request.rounds = number(value);
+                } else if (key == "games") {
+                    request.games = number(value);
+                } else if (key == "seed") {
+                    request.seed = number(value);
+                } else if (key == "rules") {
+                    const auto &names = ruleVariantNames();
+                    auto it = std::find_if(names.begin(), names.end(),
+                                           [&value](const auto &entry) { return entry.first == value; });
+                    if (it == names.end()) {
+                        throw BadRequestException();
+                    }
+                    request.rules = it->second;
+                } else {
+                    throw BadRequestException();
+                }
+            } catch (const std::logic_error &) {
+                throw BadRequestException();
+            }
+        }
+        auto [diesNumber, maxPlayers] = dispatchRules(request.rules, [](auto rules) {
+            return std::pair(rules.diesNumber, rules.maxPlayers);
+        });
+        if (request.dice.empty()) {
+            request.dice.assign(diesNumber, fairDieWeights(6));
+        }
+        if (request.players.size() > std::min<std::size_t>(maxPlayers, ShardTotals::SEATS)) {
+            throw BadRequestException();
+        }
+        return request;
+    }
+
+    inline std::string format(const ShardTotals &totals, std::size_t players) {
+        std::ostringstream out;
+        out << "games=" << totals.games << " rounds=" << totals.rounds << " nowinner=" << totals.noWinner << " wins=";
+        for (std::size_t seat = 0; seat < players; seat++) {
+            out << (seat ? "," : "") << totals.wins[seat];
+        }
+        return out.str();
+    }
+
+}
+
+// Pula wątków żyjących przez cały czas działania usługi.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threads) {
+        for (unsigned int t = 0; t < std::max(threads, 1u); t++) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard lock(mutex);
+            tasks.push(std::move(task));
+        }
+        wakeUp.notify_one();
+    }
+
+    [[nodiscard]] unsigned int size() const {
+        return workers.size();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex);
+                wakeUp.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+// Pamięć podręczna wyników z wymianą LRU, zapisywana do pliku.
+class ResultCache {
+public:
+    ResultCache(std::size_t capacity, std::string path) : capacity(std::max<std::size_t>(capacity, 1)),
+                                                          path(std::move(path)) {
+        load();
+    }
+
+    bool get(const std::string &key, std::string &value) {
+        std::lock_guard lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    // Dopisuje wpis do pliku. Gdy dopisanych wpisów jest ponad dwa razy
+    // więcej niż mieści pamięć, plik jest zapisywany na nowo.
+    void put(const std::string &key, const std::string &value) {
+        std::lock_guard lock(mutex);
+        insert(key, value);
+        if (path.empty()) {
+            return;
+        }
+        if (++appended > 2 * capacity) {
+            compact();
+        } else {
+            std::ofstream(path, std::ios::app) << key << '\t' << value << '\n';
+        }
+    }
+
+private:
+    std::size_t capacity;
+    std::string path;
+    std::size_t appended = 0;
+    std::mutex mutex;
+    std::list<std::pair<std::string, std::string>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> index;
+
+    void insert(const std::string &key, const std::string &value) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = value;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    // Wczytuje plik i od razu zapisuje go na nowo tylko z zachowanymi
+    // wpisami.
+    void load() {
+        if (path.empty()) {
+            return;
+        }
+        {
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                auto tab = line.find('\t');
+                if (tab != std::string::npos) {
+                    insert(line.substr(0, tab), line.substr(tab + 1));
+                }
+            }
+        }
+        compact();
+    }
+
+    // Zapisuje plik od nowa, od najdawniej używanego wpisu, żeby po
+    // wczytaniu kolejność LRU była taka sama.
+    void compact() {
+        std::ofstream out(path, std::ios::trunc);
+        for (auto it = entries.rbegin(); it != entries.rend(); it++) {
+            out << it->first << '\t' << it->second << '\n';
+        }
+        appended = 0;
+    }
+};
+
+// Silnik z kostkami danego rodzaju, trzymany przez wątek puli między
+// żądaniami.
+template<typename Rules>
+struct WarmEngine {
+    BasicWorldCup<Rules> engine;
+    std::vector<std::shared_ptr<RandomDie>> dice;
+};
+
+// Kilka ostatnio używanych rozgrzanych silników jednego wątku (LRU według
+// wag kostek), żeby żądania z coraz to innymi kostkami nie zajmowały
+// pamięci bez końca.
+template<typename Rules>
+class WarmEngines {
+public:
+    explicit WarmEngines(std::size_t capacity) : capacity(std::max<std::size_t>(capacity, 1)) {}
+
+    WarmEngine<Rules> &get(const std::vector<std::vector<double>> &dice) {
+        auto it = std::find_if(engines.begin(), engines.end(), [&dice](const auto &entry) {
+            return entry.first == dice;
+        });
+        if (it != engines.end()) {
+            engines.splice(engines.begin(), engines, it);
+            return *engines.front().second;
+        }
+        auto warm = std::make_unique<WarmEngine<Rules>>();
+        for (const auto &weights : dice) {
+            warm->dice.push_back(std::make_shared<RandomDie>(weights));
+            warm->engine.addDie(warm->dice.back());
+        }
+        engines.emplace_front(dice, std::move(warm));
+        if (engines.size() > capacity) {
+            engines.pop_back();
+        }
+        return *engines.front().second;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return engines.size();
+    }
+
+private:
+    std::size_t capacity;
+    std::list<std::pair<std::vector<std::vector<double>>, std::unique_ptr<WarmEngine<Rules>>>> engines;
+};
+
+class SimulationDaemon {
+public:
+    class SocketException : public std::exception {};
+
+    SimulationDaemon(unsigned int threads, std::size_t cacheCapacity, std::string cachePath) :
+                     pool(threads), cache(cacheCapacity, std::move(cachePath)) {}
+
+    // Odpowiada na jedno żądanie (bez udziału gniazda).
+    std::string handle(const std::string &line) {
+        daemon_protocol::Request request;
+        try {
+            request = daemon_protocol::parse(line);
+        } catch (const daemon_protocol::BadRequestException &) {
+            return "error bad request";
+        }
+        std::string key = request.canonical();
+        std::string result;
+        if (cache.get(key, result)) {
+            return "ok cached=1 " + result;
+        }
+        try {
+            result = daemon_protocol::format(simulate(request), request.players.size());
+        } catch (const std::exception &) {
+            return "error simulation failed";
+        }
+        cache.put(key, result);
+        return "ok cached=0 " + result;
+    }
+
+    // Obsługuje połączenia na gnieździe uniksowym do wywołania stop().
+    void serve(const std::string &socketPath) {
+        listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (listener < 0 || socketPath.size() >= sizeof(address.sun_path)) {
+            throw SocketException();
+        }
+        socketPath.copy(address.sun_path, socketPath.size());
+        ::unlink(socketPath.c_str());
+        if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listener, 64) != 0) {
+            ::close(listener);
+            throw SocketException();
+        }
+        // Zakończone połączenia są sprzątane przy każdym kolejnym, więc
+        // liczba wątków nie rośnie z liczbą obsłużonych połączeń.
+        std::list<Connection> connections;
+        while (!stopping.load()) {
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            for (auto it = connections.begin(); it != connections.end();) {
+                if (it->finished.load(std::memory_order_acquire)) {
+                    it->thread.join();
+                    it = connections.erase(it);
+                } else {
+                    it++;
+                }
+            }
+            Connection &connection = connections.emplace_back();
+            connection.thread = std::thread([this, client, &finished = connection.finished] {
+                converse(client);
+                finished.store(true, std::memory_order_release);
+            });
+        }
+        for (Connection &connection : connections) {
+            connection.thread.join();
+        }
+        ::close(listener);
+        ::unlink(socketPath.c_str());
+    }
+
+    void stop() {
+        stopping = true;
+        ::shutdown(listener, SHUT_RDWR);
+    }
+
+private:
+    struct Connection {
+        std::thread thread;
+        std::atomic<bool> finished = false;
+    };
+
+    ThreadPool pool;
+    ResultCache cache;
+    std::atomic<bool> stopping = false;
+    int listener = -1;
+
+    static constexpr std::size_t warmEnginesPerThread = 8;
+
+    // Osobno dla każdego wariantu zasad.
+    template<typename Rules>
+    static WarmEngine<Rules> &warmEngine(const std::vector<std::vector<double>> &dice) {
+        thread_local WarmEngines<Rules> engines(warmEnginesPerThread);
+        return engines.get(dice);
+    }
+
+    ShardTotals simulate(const daemon_protocol::Request &request) {
+        const std::uint64_t tasks = std::min<std::uint64_t>(request.games, pool.size() * 4);
+        std::vector<ShardTotals> parts(tasks);
+        std::mutex mutex;
+        std::condition_variable done;
+        std::uint64_t remaining = tasks;
+        std::atomic<bool> failed = false;
+        for (std::uint64_t t = 0; t < tasks; t++) {
+            pool.submit([&, t] {
+                try {
+                    dispatchRules(request.rules, [&](auto rules) {
+                        auto &warm = warmEngine<decltype(rules)>(request.dice);
+                        simulateSeededRange(warm.engine, warm.dice, request.players, request.rounds,
+                                            request.seed + request.games * t / tasks,
+                                            request.seed + request.games * (t + 1) / tasks,
+                                            [&part = parts[t]](std::uint64_t, const GameOutcome &outcome) {
+                                                part.add(outcome);
+                                            });
+                    });
+                } catch (...) {
+                    failed = true;
+                }
+                std::lock_guard lock(mutex);
+                if (--remaining == 0) {
+                    done.notify_one();
+                }
+            });
+        }
+        {
+            std::unique_lock lock(mutex);
+            done.wait(lock, [&] { return remaining == 0; });
+        }
+        if (failed) {
+            throw daemon_protocol::BadRequestException();
+        }
+        ShardTotals totals;
+        for (const ShardTotals &part : parts) {
+            totals.merge(part);
+        }
+        return totals;
+    }
+
+    void converse(int client) {
+        std::string buffer;
+        char chunk[4096];
+        ssize_t received;
+        while ((received = ::read(client, chunk, sizeof(chunk))) > 0) {
+            buffer.append(chunk, received);
+            std::size_t newline;
+            while ((newline = buffer.find('\n')) != std::string::npos) {
+                std::string response = handle(buffer.substr(0, newline)) + "\n";
+                buffer.erase(0, newline + 1);
+                if (::write(client, response.data(), response.size()) < 0) {
+                    ::close(client);
+                    return;
+                }
+            }
+        }
+        ::close(client);
+    }
+};
+
+// Wysyła jedno żądanie do działającej usługi i zwraca odpowiedź.
+inline std::string queryDaemon(const std::string &socketPath, const std::string &request) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (fd < 0 || socketPath.size() >= sizeof(address.sun_path)) {
+        throw SimulationDaemon::SocketException();
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        throw SimulationDaemon::SocketException();
+    }
+    std::string line = request + "\n";
+    std::string response;
+    if (::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size())) {
+        char c;
+        while (::read(fd, &c, 1) == 1 && c != '\n') {
+            response.push_back(c);
+        }
+    }
+    ::close(fd);
+    return response;
+}
+
+#endif
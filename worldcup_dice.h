@@ -0,0 +1,110 @@
+#ifndef WORLDCUP_DICE_H
+#define WORLDCUP_DICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "worldcup.h"
+
+// Opis rozkładów kostek potrzebny silnikowi. Kostki losowe (RandomDie,
+// TiltedDie) są w worldcup_random_dice.h, żeby nagłówek silnika nie dołączał
+// <random>.
+
+// Wagi uczciwej kostki o podanej liczbie ścian. We wszystkich kostkach
+// losowych waga o indeksie k to prawdopodobieństwo wyrzucenia k oczek.
+inline std::vector<double> fairDieWeights(unsigned short sides) {
+    std::vector<double> weights(sides + 1, 1.0);
+    weights[0] = 0.0;
+    return weights;
+}
+
+// Kostka o znanym rozkładzie. Silnik może zamiast wołać roll() każdej kostki
+// z osobna policzyć rozkład sumy i losować go jednym losowaniem z generatora
+// pierwszej kostki (zob. AliasTable).
+class DistributionDie : public Die {
+public:
+    [[nodiscard]] virtual const std::vector<double> &faceWeights() const = 0;
+
+    // Kolejna surowa liczba losowa z generatora kostki.
+    [[nodiscard]] virtual std::uint64_t nextRandom() const = 0;
+};
+
+// Tablica aliasów (metoda Vose'a): losowanie z dowolnego rozkładu
+// dyskretnego w czasie stałym, z jednej 64-bitowej liczby losowej.
+class AliasTable {
+private:
+    std::vector<std::uint32_t> threshold;
+    std::vector<unsigned int> alias;
+
+public:
+    AliasTable() = default;
+
+    explicit AliasTable(const std::vector<double> &weights) : threshold(weights.size()), alias(weights.size()) {
+        const std::size_t n = weights.size();
+        double total = 0.0;
+        for (double w : weights) {
+            total += w;
+        }
+        std::vector<double> scaled(n);
+        std::vector<unsigned int> small;
+        std::vector<unsigned int> large;
+        for (std::size_t i = 0; i < n; i++) {
+            scaled[i] = weights[i] * static_cast<double>(n) / total;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty()) {
+            unsigned int s = small.back();
+            unsigned int l = large.back();
+            small.pop_back();
+            threshold[s] = static_cast<std::uint32_t>(scaled[s] * 4294967296.0);
+            alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        for (unsigned int i : small) {
+            threshold[i] = ~0u;
+            alias[i] = i;
+        }
+        for (unsigned int i : large) {
+            threshold[i] = ~0u;
+            alias[i] = i;
+        }
+    }
+
+    [[nodiscard]] bool empty() const {
+        return threshold.empty();
+    }
+
+    // Górne 32 bity wybierają kolumnę, dolne rozstrzygają między nią
+    // a jej aliasem.
+    [[nodiscard]] unsigned int sample(std::uint64_t random) const {
+        auto column = static_cast<unsigned int>(((random >> 32) * threshold.size()) >> 32);
+        return static_cast<std::uint32_t>(random) < threshold[column] ? column : alias[column];
+    }
+};
+
+// Rozkład sumy oczek niezależnych kostek (splot ich rozkładów).
+inline std::vector<double> sumDistribution(const std::vector<std::vector<double>> &dice) {
+    std::vector<double> sum = {1.0};
+    for (const std::vector<double> &weights : dice) {
+        double total = 0.0;
+        for (double w : weights) {
+            total += w;
+        }
+        std::vector<double> next(sum.size() + weights.size() - 1, 0.0);
+        for (std::size_t i = 0; i < sum.size(); i++) {
+            for (std::size_t k = 0; k < weights.size(); k++) {
+                next[i + k] += sum[i] * weights[k] / total;
+            }
+        }
+        sum = std::move(next);
+    }
+    return sum;
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef WORLDCUP_ESTIMATION_H
+#define WORLDCUP_ESTIMATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "worldcup_random_dice.h"
+#include "worldcup_simulation.h"
+
+// Oszacowanie Monte Carlo wraz z przedziałem ufności.
+struct Estimate {
+    double value = 0.0;
+    double standardError = 0.0;
+    double low = 0.0;
+    double high = 0.0;
+    std::uint64_t games = 0;
+    // Efektywna liczba prób (Kish); przy równych wagach równa games.
+    double effectiveGames = 0.0;
+    // Czy osiągnięto żądaną precyzję (a nie np. limit czasu).
+    bool converged = false;
+};
+
+// Kwantyl rozkładu normalnego dla 95% przedziału ufności.
+inline constexpr double CONFIDENCE_Z = 1.959963984540054;
+
+// Takie z, że P(|Z| > z) = alpha dla standardowego rozkładu normalnego
+// (bisekcja po erfc; wystarcza dla alpha aż do ok. 1e-300).
+inline double twoSidedNormalQuantile(double alpha) {
+    double low = 0.0;
+    double high = 40.0;
+    for (int step = 0; step < 100; step++) {
+        double middle = (low + high) / 2.0;
+        (std::erfc(middle / std::sqrt(2.0)) > alpha ? low : high) = middle;
+    }
+    return (low + high) / 2.0;
+}
+
+// Szacuje prawdopodobieństwo rzadkich zdarzeń metodą losowania istotnościowego.
+// Wszystkie kostki losują z rozkładu proposal zamiast nominal, a każda gra
+// dostaje wagę równą iloczynowi p/q swoich rzutów, więc średnia ważona
+// wskaźnika zdarzenia jest nieobciążonym estymatorem jego prawdopodobieństwa
+// przy rzutach nominalnych. Gry toczą się według DefaultRules.
+class ImportanceSampler {
+public:
+    using Event = std::function<bool(const GameOutcome &)>;
+
+    ImportanceSampler(std::vector<std::string> players, std::vector<double> nominal,
+                      std::vector<double> proposal, unsigned int rounds, std::uint64_t seed = 0) :
+                      players(std::move(players)), rounds(rounds) {
+        for (unsigned int d = 0; d < DefaultRules::diesNumber; d++) {
+            engine.addDie(std::make_shared<TiltedDie>(nominal, proposal, ratio, seed * DefaultRules::diesNumber + d));
+        }
+    }
+
+    Estimate estimate(const Event &event, std::uint64_t games) {
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        double weightSum = 0.0;
+        double weightSquares = 0.0;
+        for (std::uint64_t g = 0; g < games; g++) {
+            ratio->reset();
+            GameOutcome outcome = simulateGame(engine, players, rounds);
+            double weight = ratio->weight();
+            double sample = event(outcome) ? weight : 0.0;
+            sum += sample;
+            sumSquares += sample * sample;
+            weightSum += weight;
+            weightSquares += weight * weight;
+        }
+
+        Estimate result;
+        result.games = games;
+        if (games == 0) {
+            return result;
+        }
+        auto n = static_cast<double>(games);
+        result.value = sum / n;
+        double variance = games > 1 ? (sumSquares - n * result.value * result.value) / (n - 1) : 0.0;
+        result.standardError = std::sqrt(std::max(variance, 0.0) / n);
+        result.low = result.value - CONFIDENCE_Z * result.standardError;
+        result.high = result.value + CONFIDENCE_Z * result.standardError;
+        result.effectiveGames = weightSquares > 0.0 ? weightSum * weightSum / weightSquares : 0.0;
+        return result;
+    }
+
+private:
+    std::vector<std::string> players;
+    unsigned int rounds;
+    std::shared_ptr<LikelihoodRatio> ratio = std::make_shared<LikelihoodRatio>();
+    WorldCup2022 engine;
+};
+
+// Przedział Wilsona dla prawdopodobieństwa przy successes sukcesach na games
+// (domyślnie 95%; z to kwantyl rozkładu normalnego).
+inline Estimate wilsonInterval(std::uint64_t successes, std::uint64_t games, double z = CONFIDENCE_Z) {
+    Estimate result;
+    result.games = games;
+    result.effectiveGames = static_cast<double>(games);
+    if (games == 0) {
+        result.high = 1.0;
+        return result;
+    }
+    auto n = static_cast<double>(games);
+    double p = static_cast<double>(successes) / n;
+    double z2 = z * z;
+    double denominator = 1.0 + z2 / n;
+    double center = (p + z2 / (2.0 * n)) / denominator;
+    double halfWidth = z / denominator * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n));
+    result.value = p;
+    result.standardError = std::sqrt(p * (1.0 - p) / n);
+    result.low = std::max(0.0, center - halfWidth);
+    result.high = std::min(1.0, center + halfWidth);
+    return result;
+}
+
+// Szacuje prawdopodobieństwo zdarzenia, rozgrywając gry partiami aż połowa
+// szerokości przedziału Wilsona spadnie do zadanej precyzji, minie termin
+// albo skończy się limit gier. Zwraca oszacowanie wraz z osiągniętym
+// przedziałem. Gry toczą się według DefaultRules.
+//
+// Decyzja o zatrzymaniu zależy od danych, więc przedział ze stałym poziomem
+// 95% sprawdzany po każdej partii pokrywałby prawdziwą wartość rzadziej niż
+// deklaruje. Dlatego k-te sprawdzenie (k = 1, 2, ...) używa poziomu
+// 1 - alpha / (k (k + 1)): suma tych błędów to alpha, więc z
+// prawdopodobieństwem co najmniej 1 - alpha wszystkie sprawdzane przedziały
+// naraz, a w szczególności zwrócony, pokrywają prawdziwą wartość. Przedziały
+// rosną z liczbą sprawdzeń tylko logarytmicznie; większy batch to mniej
+// sprawdzeń i węższy przedział przy tej samej liczbie gier.
+class SequentialEstimator {
+public:
+    using Event = std::function<bool(const GameOutcome &)>;
+
+    struct StoppingRule {
+        double halfWidth = 0.001;
+        std::chrono::nanoseconds deadline = std::chrono::nanoseconds::max();
+        std::uint64_t maxGames = ~std::uint64_t(0);
+        std::uint64_t minGames = 100;
+        // Co ile gier sprawdzany jest przedział i zegar.
+        std::uint64_t batch = 64;
+        // Łączne prawdopodobieństwo błędu wszystkich sprawdzanych przedziałów.
+        double alpha = 0.05;
+    };
+
+    SequentialEstimator(std::vector<std::string> players, unsigned int rounds,
+                        std::vector<double> dieWeights = fairDieWeights(6), std::uint64_t seed = 0) :
+                        players(std::move(players)), rounds(rounds) {
+        for (unsigned int d = 0; d < DefaultRules::diesNumber; d++) {
+            engine.addDie(std::make_shared<RandomDie>(dieWeights, seed * DefaultRules::diesNumber + d));
+        }
+    }
+
+    Estimate estimate(const Event &event, const StoppingRule &rule) {
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t successes = 0;
+        std::uint64_t games = 0;
+        Estimate result = wilsonInterval(0, 0);
+        double looks = 0.0;
+        while (games < rule.maxGames) {
+            std::uint64_t batchEnd = std::min(rule.maxGames, games + std::max<std::uint64_t>(rule.batch, 1));
+            for (; games < batchEnd; games++) {
+                if (event(simulateGame(engine, players, rounds))) {
+                    successes++;
+                }
+            }
+            looks += 1.0;
+            result = wilsonInterval(successes, games, twoSidedNormalQuantile(rule.alpha / (looks * (looks + 1.0))));
+            if (games >= rule.minGames && (result.high - result.low) / 2.0 <= rule.halfWidth) {
+                result.converged = true;
+                break;
+            }
+            if (std::chrono::steady_clock::now() - start >= rule.deadline) {
+                break;
+            }
+        }
+        return result;
+    }
+
+private:
+    std::vector<std::string> players;
+    unsigned int rounds;
+    WorldCup2022 engine;
+};
+
+#endif
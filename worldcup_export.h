@@ -0,0 +1,354 @@
+#ifndef WORLDCUP_EXPORT_H
+#define WORLDCUP_EXPORT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "worldcup2022.h"
+
+// Kolumnowy format plików z migawkami rozgrywek.
+//
+// Plik: magiczne "WCC1", liczba kolumn (u32), kodowania kolumn (po u8),
+// a dalej ciąg porcji. Porcja: liczba wierszy (u32), a dla każdej kolumny
+// długość w bajtach (u64) i zakodowane wartości. Porcje są budowane w pamięci
+// (co najwyżej chunkRows wierszy), więc zapis dowolnie wielu wierszy zużywa
+// stałą ilość pamięci. Czytelnik mapuje plik przez mmap i dekoduje pojedyncze
+// kolumny pojedynczych porcji.
+namespace columnar {
+
+    enum class Encoding : std::uint8_t {
+        // Wartości jako varint.
+        plain = 0,
+        // Różnice kolejnych wartości jako zigzag varint.
+        delta = 1,
+        // Pary (wartość, długość serii) jako varint.
+        runLength = 2
+    };
+
+    class ColumnarFileException : public std::exception {};
+
+    inline constexpr char MAGIC[4] = {'W', 'C', 'C', '1'};
+
+    inline void putVarint(std::vector<std::uint8_t> &out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    inline std::uint64_t getVarint(const std::uint8_t *&in, const std::uint8_t *end) {
+        std::uint64_t value = 0;
+        for (unsigned int shift = 0; in < end && shift < 64; shift += 7) {
+            std::uint8_t byte = *in++;
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw ColumnarFileException();
+    }
+
+    inline std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    inline std::int64_t unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    inline void encode(Encoding encoding, const std::vector<std::uint64_t> &values,
+                       std::vector<std::uint8_t> &out) {
+        switch (encoding) {
+            case Encoding::plain:
+                for (std::uint64_t v : values) {
+                    putVarint(out, v);
+                }
+                break;
+            case Encoding::delta: {
+                std::uint64_t previous = 0;
+                for (std::uint64_t v : values) {
+                    putVarint(out, zigzag(static_cast<std::int64_t>(v - previous)));
+                    previous = v;
+                }
+                break;
+            }
+            case Encoding::runLength:
+                for (std::size_t i = 0; i < values.size();) {
+                    std::size_t j = i + 1;
+                    while (j < values.size() && values[j] == values[i]) {
+                        j++;
+                    }
+                    putVarint(out, values[i]);
+                    putVarint(out, j - i);
+                    i = j;
+                }
+                break;
+        }
+    }
+
+    inline void decode(Encoding encoding, const std::uint8_t *in, const std::uint8_t *end,
+                       std::size_t rows, std::vector<std::uint64_t> &values) {
+        values.clear();
+        values.reserve(rows);
+        switch (encoding) {
+            case Encoding::plain:
+                while (values.size() < rows) {
+                    values.push_back(getVarint(in, end));
+                }
+                break;
+            case Encoding::delta: {
+                std::uint64_t previous = 0;
+                while (values.size() < rows) {
+                    previous += static_cast<std::uint64_t>(unzigzag(getVarint(in, end)));
+                    values.push_back(previous);
+                }
+                break;
+            }
+            case Encoding::runLength:
+                while (values.size() < rows) {
+                    std::uint64_t value = getVarint(in, end);
+                    std::uint64_t length = getVarint(in, end);
+                    if (length > rows - values.size()) {
+                        throw ColumnarFileException();
+                    }
+                    values.insert(values.end(), length, value);
+                }
+                break;
+            default:
+                throw ColumnarFileException();
+        }
+    }
+
+    class Writer {
+    private:
+        std::FILE *file;
+        std::vector<Encoding> encodings;
+        std::vector<std::vector<std::uint64_t>> columns;
+        std::size_t chunkRows;
+        std::vector<std::uint8_t> encoded;
+        std::vector<std::uint8_t> chunk;
+
+        void write(const void *data, std::size_t size) {
+            if (std::fwrite(data, 1, size, file) != size) {
+                throw ColumnarFileException();
+            }
+        }
+
+    public:
+        Writer(const std::string &path, std::vector<Encoding> encodings, std::size_t chunkRows = 1 << 16) :
+               encodings(std::move(encodings)), columns(this->encodings.size()), chunkRows(chunkRows) {
+            file = std::fopen(path.c_str(), "wb");
+            if (file == nullptr) {
+                throw ColumnarFileException();
+            }
+            for (auto &column : columns) {
+                column.reserve(chunkRows);
+            }
+            auto count = static_cast<std::uint32_t>(this->encodings.size());
+            write(MAGIC, sizeof(MAGIC));
+            write(&count, sizeof(count));
+            write(this->encodings.data(), this->encodings.size());
+        }
+
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        ~Writer() {
+            try {
+                flush();
+            } catch (const ColumnarFileException &) {}
+            std::fclose(file);
+        }
+
+        void append(std::initializer_list<std::uint64_t> row) {
+            assert(row.size() == columns.size());
+            auto column = columns.begin();
+            for (std::uint64_t value : row) {
+                (column++)->push_back(value);
+            }
+            if (columns.front().size() == chunkRows) {
+                flush();
+            }
+        }
+
+        // Koduje zbuforowane wiersze i zapisuje je jako jedną porcję.
+        void flush() {
+            if (columns.empty() || columns.front().empty()) {
+                return;
+            }
+            chunk.clear();
+            auto rows = static_cast<std::uint32_t>(columns.front().size());
+            chunk.insert(chunk.end(), reinterpret_cast<const std::uint8_t *>(&rows),
+                         reinterpret_cast<const std::uint8_t *>(&rows) + sizeof(rows));
+            for (std::size_t c = 0; c < columns.size(); c++) {
+                encoded.clear();
+                encode(encodings[c], columns[c], encoded);
+                std::uint64_t size = encoded.size();
+                chunk.insert(chunk.end(), reinterpret_cast<const std::uint8_t *>(&size),
+                             reinterpret_cast<const std::uint8_t *>(&size) + sizeof(size));
+                chunk.insert(chunk.end(), encoded.begin(), encoded.end());
+                columns[c].clear();
+            }
+            write(chunk.data(), chunk.size());
+        }
+    };
+
+    class Reader {
+    private:
+        struct Chunk {
+            std::uint32_t rows;
+            std::vector<std::pair<const std::uint8_t *, const std::uint8_t *>> columns;
+        };
+
+        const std::uint8_t *data = nullptr;
+        std::size_t length = 0;
+        std::vector<Encoding> encodings;
+        std::vector<Chunk> chunks;
+
+        template <typename T>
+        T read(std::size_t &offset) const {
+            if (length - offset < sizeof(T)) {
+                throw ColumnarFileException();
+            }
+            T value;
+            std::memcpy(&value, data + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        void index() {
+            std::size_t offset = 0;
+            if (length < sizeof(MAGIC) || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+                throw ColumnarFileException();
+            }
+            offset += sizeof(MAGIC);
+            auto count = read<std::uint32_t>(offset);
+            for (std::uint32_t c = 0; c < count; c++) {
+                encodings.push_back(static_cast<Encoding>(read<std::uint8_t>(offset)));
+            }
+            while (offset < length) {
+                Chunk chunk{read<std::uint32_t>(offset), {}};
+                for (std::uint32_t c = 0; c < count; c++) {
+                    auto size = read<std::uint64_t>(offset);
+                    if (length - offset < size) {
+                        throw ColumnarFileException();
+                    }
+                    chunk.columns.emplace_back(data + offset, data + offset + size);
+                    offset += size;
+                }
+                chunks.push_back(std::move(chunk));
+            }
+        }
+
+    public:
+        explicit Reader(const std::string &path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw ColumnarFileException();
+            }
+            struct stat st {};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw ColumnarFileException();
+            }
+            length = static_cast<std::size_t>(st.st_size);
+            void *mapped = length > 0 ? ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            ::close(fd);
+            if (mapped == MAP_FAILED) {
+                throw ColumnarFileException();
+            }
+            data = static_cast<const std::uint8_t *>(mapped);
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+            try {
+                index();
+            } catch (...) {
+                ::munmap(mapped, length);
+                throw;
+            }
+        }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        ~Reader() {
+            ::munmap(const_cast<std::uint8_t *>(data), length);
+        }
+
+        [[nodiscard]] std::size_t columnCount() const {
+            return encodings.size();
+        }
+
+        [[nodiscard]] std::size_t chunkCount() const {
+            return chunks.size();
+        }
+
+        [[nodiscard]] std::size_t rows(std::size_t chunk) const {
+            return chunks[chunk].rows;
+        }
+
+        // Dekoduje jedną kolumnę jednej porcji do podanego wektora.
+        void column(std::size_t chunk, std::size_t column, std::vector<std::uint64_t> &values) const {
+            const auto &[begin, end] = chunks[chunk].columns[column];
+            decode(encodings[column], begin, end, chunks[chunk].rows, values);
+        }
+    };
+
+}
+
+// Zapisuje migawki rozgrywek do dwóch plików kolumnowych:
+// <prefix>.players.wcc: gra, runda, gracz, pozycja, pieniądze, czekanie;
+// <prefix>.pots.wcc: gra, runda, pole, pula.
+// Numery gier są nadawane kolejno od firstGameId przy każdym play(),
+// a chunkRows ogranicza liczbę wierszy w jednej porcji obu plików.
+class ColumnarExporter : public RoundRecorder {
+public:
+    enum PlayerColumn {playerGame, playerRound, playerId, playerPosition, playerMoney, playerSuspension};
+    enum PotColumn {potGame, potRound, potSquare, potValue};
+
+    explicit ColumnarExporter(const std::string &prefix, std::uint64_t firstGameId = 0,
+                              std::size_t chunkRows = 1 << 16) :
+        players(prefix + ".players.wcc", {columnar::Encoding::runLength, columnar::Encoding::runLength,
+                                          columnar::Encoding::delta, columnar::Encoding::delta,
+                                          columnar::Encoding::delta, columnar::Encoding::runLength},
+                chunkRows),
+        pots(prefix + ".pots.wcc", {columnar::Encoding::runLength, columnar::Encoding::runLength,
+                                    columnar::Encoding::delta, columnar::Encoding::plain},
+             chunkRows),
+        gameId(firstGameId - 1) {}
+
+    void onGameStart() override {
+        gameId++;
+    }
+
+    void onPlayerState(unsigned int roundNo, unsigned int playerId, unsigned int position,
+                       unsigned int money, unsigned int suspension) override {
+        players.append({gameId, roundNo, playerId, position, money, suspension});
+    }
+
+    void onPot(unsigned int roundNo, unsigned int square, unsigned int pot) override {
+        pots.append({gameId, roundNo, square, pot});
+    }
+
+    void flush() {
+        players.flush();
+        pots.flush();
+    }
+
+private:
+    columnar::Writer players;
+    columnar::Writer pots;
+    std::uint64_t gameId;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef WORLDCUP_HISTOGRAM_H
+#define WORLDCUP_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "worldcup_simulation.h"
+
+// Histogram o stałym rozmiarze w stylu HDR: wartości mniejsze niż
+// 2^SUB_BITS są liczone dokładnie, większe trafiają do kubełków wyznaczonych
+// przez wykładnik i SUB_BITS najstarszych bitów mantysy, więc błąd względny
+// kwantyli nie przekracza 2^-SUB_BITS (poniżej 1%). Histogramy z różnych
+// wątków scala się przez dodanie liczników.
+class Histogram {
+public:
+    static constexpr unsigned int SUB_BITS = 7;
+    static constexpr unsigned int SUB_BUCKETS = 1u << SUB_BITS;
+    static constexpr unsigned int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    void record(std::uint64_t value, std::uint64_t count = 1) {
+        counts[bucket(value)] += count;
+        total += count;
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+
+    void merge(const Histogram &other) {
+        for (unsigned int i = 0; i < BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    [[nodiscard]] std::uint64_t count() const {
+        return total;
+    }
+
+    [[nodiscard]] std::uint64_t min() const {
+        return total == 0 ? 0 : minimum;
+    }
+
+    [[nodiscard]] std::uint64_t max() const {
+        return maximum;
+    }
+
+    // Wartość, poniżej której leży ułamek q zapisanych wartości (q z [0, 1]).
+    [[nodiscard]] std::uint64_t quantile(double q) const {
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+        std::uint64_t seen = 0;
+        for (unsigned int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > rank) {
+                return std::clamp(highest(i), minimum, maximum);
+            }
+        }
+        return maximum;
+    }
+
+private:
+    std::array<std::uint64_t, BUCKETS> counts{};
+    std::uint64_t total = 0;
+    std::uint64_t minimum = ~std::uint64_t(0);
+    std::uint64_t maximum = 0;
+
+    static unsigned int bucket(std::uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<unsigned int>(value);
+        }
+        unsigned int shift = std::bit_width(value) - SUB_BITS - 1;
+        return (shift + 1) * SUB_BUCKETS + static_cast<unsigned int>(value >> shift) - SUB_BUCKETS;
+    }
+
+    // Największa wartość trafiająca do kubełka.
+    static std::uint64_t highest(unsigned int index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        unsigned int shift = index / SUB_BUCKETS - 1;
+        std::uint64_t mantissa = index % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+};
+
+// Rozkłady wyników gier: długość gry w rundach, końcowe saldo każdego gracza
+// i runda bankructwa każdego bankruta.
+struct ResultHistograms {
+    Histogram rounds;
+    Histogram finalBalance;
+    Histogram bankruptcyRound;
+
+    void add(const GameOutcome &outcome) {
+        rounds.record(outcome.rounds);
+        for (std::size_t seat = 0; seat < outcome.balances.size(); seat++) {
+            finalBalance.record(outcome.balances[seat]);
+            if (outcome.bankruptcyRound[seat] != GameOutcome::NOT_BANKRUPT) {
+                bankruptcyRound.record(outcome.bankruptcyRound[seat]);
+            }
+        }
+    }
+
+    void merge(const ResultHistograms &other) {
+        rounds.merge(other.rounds);
+        finalBalance.merge(other.finalBalance);
+        bankruptcyRound.merge(other.bankruptcyRound);
+    }
+};
+
+// Tablica wyników wypełniająca histogramy na koniec każdej gry. Każdy wątek
+// powinien mieć własną; po zakończeniu pracy wątków scala się je przez
+// ResultHistograms::merge() bez żadnej synchronizacji w trakcie gry. Saldo
+// początkowe musi być takie jak w zasadach silnika (Rules::startingBalance),
+// bo gracz, który nie zdążył wykonać ruchu, kończy grę z tym saldem.
+class HistogramScoreBoard : public OutcomeScoreBoard {
+private:
+    ResultHistograms collected;
+
+public:
+    explicit HistogramScoreBoard(std::vector<std::string> players,
+                                 unsigned int startingBalance = DefaultRules::startingBalance) :
+                                 OutcomeScoreBoard(std::move(players), startingBalance) {}
+
+    void onWin(std::string const &playerName) override {
+        OutcomeScoreBoard::onWin(playerName);
+        collected.add(outcome());
+    }
+
+    [[nodiscard]] const ResultHistograms &histograms() const {
+        return collected;
+    }
+};
+
+#endif
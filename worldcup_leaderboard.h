@@ -0,0 +1,260 @@
+#ifndef WORLDCUP_LEADERBOARD_H
+#define WORLDCUP_LEADERBOARD_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "worldcup_simulation.h"
+
+// Zbiorcze statystyki na żywo z wielu gier toczonych równolegle w wielu
+// wątkach: liczba gier, zwycięstwa według miejsca i nazwy gracza oraz
+// bankructwa według pola.
+//
+// Każdy wątek dostaje własny kawałek liczników, więc zapis nie rywalizuje
+// z innymi wątkami. Kawałki tworzą listę jednokierunkową, do której nowy
+// kawałek jest dopisywany na początek przez compare-exchange, więc ani
+// rejestracja, ani czytanie listy nie biorą blokady. Wynik gry jest
+// publikowany w całości na koniec (onWin) pod licznikiem sekwencyjnym
+// kawałka, dzięki czemu czytelnik widzi każdą grę w całości albo wcale
+// i nigdy nie blokuje piszących.
+//
+// Kawałki należą do tablicy i giną razem z nią. Wątek odnajduje swój kawałek
+// po identyfikatorze wątku, a kawałek zakończonego wątku przejmuje następny
+// wątek o tym samym identyfikatorze, więc kawałków jest najwyżej tyle, ile
+// wątków pisało naraz.
+class LiveLeaderboard {
+public:
+    struct Snapshot {
+        std::uint64_t games = 0;
+        std::uint64_t noWinner = 0;
+        // DefaultRules::maxPlayers miejsc (limit wspólny dla wbudowanych
+        // wariantów); zwycięzcy z dalszych miejsc, np. w trybie ligowym, są
+        // liczeni tylko w winsByName.
+        std::vector<std::uint64_t> winsBySeat;
+        // Ostatni element zlicza graczy spoza listy podanej w konstruktorze.
+        std::vector<std::uint64_t> winsByName;
+        // Ostatni element zlicza pola spoza listy podanej w konstruktorze.
+        std::vector<std::uint64_t> bankruptciesByField;
+    };
+
+    LiveLeaderboard(const std::vector<std::string> &playerNames, const std::vector<std::string> &fieldNames) :
+                    id(nextId()), names(playerNames.size() + 1), fields(fieldNames.size() + 1) {
+        for (unsigned int i = 0; i < playerNames.size(); i++) {
+            nameIndex.try_emplace(playerNames[i], i);
+        }
+        for (unsigned int i = 0; i < fieldNames.size(); i++) {
+            fieldIndex.try_emplace(fieldNames[i], i);
+        }
+    }
+
+    LiveLeaderboard(const LiveLeaderboard &) = delete;
+    LiveLeaderboard &operator=(const LiveLeaderboard &) = delete;
+
+    ~LiveLeaderboard() {
+        Shard *shard = head.load(std::memory_order_acquire);
+        while (shard != nullptr) {
+            delete std::exchange(shard, shard->next);
+        }
+    }
+
+    // Tablica wyników dla jednej gry o podanych graczach (w kolejności
+    // dodawania do silnika). Używać w wątku, który rozgrywa tę grę.
+    std::shared_ptr<ScoreBoard> session(std::vector<std::string> players) {
+        return std::make_shared<Session>(*this, std::move(players));
+    }
+
+    // Spójny stan wszystkich opublikowanych gier; nie blokuje piszących.
+    [[nodiscard]] Snapshot snapshot() const {
+        Snapshot total;
+        total.winsBySeat.assign(DefaultRules::maxPlayers, 0);
+        total.winsByName.assign(names, 0);
+        total.bankruptciesByField.assign(fields, 0);
+        for (const Shard *shard = head.load(std::memory_order_acquire); shard != nullptr; shard = shard->next) {
+            Snapshot part = shard->read();
+            total.games += part.games;
+            total.noWinner += part.noWinner;
+            for (std::size_t i = 0; i < total.winsBySeat.size(); i++) {
+                total.winsBySeat[i] += part.winsBySeat[i];
+            }
+            for (std::size_t i = 0; i < total.winsByName.size(); i++) {
+                total.winsByName[i] += part.winsByName[i];
+            }
+            for (std::size_t i = 0; i < total.bankruptciesByField.size(); i++) {
+                total.bankruptciesByField[i] += part.bankruptciesByField[i];
+            }
+        }
+        return total;
+    }
+
+    // Liczba kawałków liczników, czyli wątków, które pisały naraz.
+    [[nodiscard]] std::size_t shardCount() const {
+        std::size_t count = 0;
+        for (const Shard *shard = head.load(std::memory_order_acquire); shard != nullptr; shard = shard->next) {
+            count++;
+        }
+        return count;
+    }
+
+private:
+    // Liczniki jednego wątku. Pisze tylko właściciel; czytelnicy kopiują je
+    // pod kontrolą licznika sekwencyjnego (nieparzysty = zapis w toku).
+    class Shard {
+    private:
+        std::atomic<std::uint64_t> sequence = 0;
+        std::atomic<std::uint64_t> games = 0;
+        std::atomic<std::uint64_t> noWinner = 0;
+        std::vector<std::atomic<std::uint64_t>> winsBySeat;
+        std::vector<std::atomic<std::uint64_t>> winsByName;
+        std::vector<std::atomic<std::uint64_t>> bankruptciesByField;
+
+        static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t by = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+        }
+
+    public:
+        const std::thread::id owner;
+        // Następny kawałek listy; niezmienny po opublikowaniu kawałka.
+        Shard *next = nullptr;
+
+        Shard(std::size_t names, std::size_t fields) :
+              winsBySeat(DefaultRules::maxPlayers), winsByName(names), bankruptciesByField(fields),
+              owner(std::this_thread::get_id()) {}
+
+        void publish(int seat, int name, const std::vector<unsigned int> &bankruptcies) {
+            std::uint64_t s = sequence.load(std::memory_order_relaxed);
+            sequence.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            if (seat == GameOutcome::NO_WINNER) {
+                bump(noWinner);
+            } else {
+                if (static_cast<std::size_t>(seat) < winsBySeat.size()) {
+                    bump(winsBySeat[seat]);
+                }
+                bump(winsByName[name]);
+            }
+            for (unsigned int field : bankruptcies) {
+                bump(bankruptciesByField[field]);
+            }
+            bump(games);
+            sequence.store(s + 2, std::memory_order_release);
+        }
+
+        [[nodiscard]] Snapshot read() const {
+            Snapshot result;
+            while (true) {
+                std::uint64_t before = sequence.load(std::memory_order_acquire);
+                if (before & 1) {
+                    continue;
+                }
+                result.games = games.load(std::memory_order_relaxed);
+                result.noWinner = noWinner.load(std::memory_order_relaxed);
+                result.winsBySeat.clear();
+                for (const auto &c : winsBySeat) {
+                    result.winsBySeat.push_back(c.load(std::memory_order_relaxed));
+                }
+                result.winsByName.clear();
+                for (const auto &c : winsByName) {
+                    result.winsByName.push_back(c.load(std::memory_order_relaxed));
+                }
+                result.bankruptciesByField.clear();
+                for (const auto &c : bankruptciesByField) {
+                    result.bankruptciesByField.push_back(c.load(std::memory_order_relaxed));
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before) {
+                    return result;
+                }
+            }
+        }
+    };
+
+    // Śledzi miejsca graczy tak jak OutcomeScoreBoard, zbiera bankructwa
+    // lokalnie i publikuje całą grę w onWin.
+    class Session : public OutcomeScoreBoard {
+    private:
+        LiveLeaderboard &board;
+        Shard &shard;
+        std::vector<std::string> players;
+        std::vector<unsigned int> bankruptcies;
+
+    public:
+        Session(LiveLeaderboard &board, std::vector<std::string> players) :
+                OutcomeScoreBoard(players), board(board), shard(board.localShard()),
+                players(std::move(players)) {}
+
+        void onRound(unsigned int roundNo) override {
+            if (roundNo == 0) {
+                bankruptcies.clear();
+            }
+            OutcomeScoreBoard::onRound(roundNo);
+        }
+
+        void onTurn(std::string const &playerName, std::string const &playerStatus,
+                    std::string const &squareName, unsigned int money) override {
+            OutcomeScoreBoard::onTurn(playerName, playerStatus, squareName, money);
+            if (playerStatus == "*** bankrut ***") {
+                bankruptcies.push_back(board.lookup(board.fieldIndex, squareName, board.fields));
+            }
+        }
+
+        void onWin(std::string const &playerName) override {
+            OutcomeScoreBoard::onWin(playerName);
+            int seat = outcome().winner;
+            int name = seat == GameOutcome::NO_WINNER ? 0 :
+                       static_cast<int>(board.lookup(board.nameIndex, players[seat], board.names));
+            shard.publish(seat, name, bankruptcies);
+            bankruptcies.clear();
+        }
+    };
+
+    const std::uint64_t id;
+    const std::size_t names;
+    const std::size_t fields;
+    std::unordered_map<std::string, unsigned int> nameIndex;
+    std::unordered_map<std::string, unsigned int> fieldIndex;
+    std::atomic<Shard *> head = nullptr;
+
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> counter = 0;
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static unsigned int lookup(const std::unordered_map<std::string, unsigned int> &index,
+                               const std::string &key, std::size_t size) {
+        auto it = index.find(key);
+        return it == index.end() ? size - 1 : it->second;
+    }
+
+    Shard &localShard() {
+        // Ostatnio używany kawałek wątku. Kluczem jest numer tablicy, a nie
+        // adres, żeby nowa tablica pod tym samym adresem nie trafiła na
+        // kawałek poprzedniej.
+        thread_local std::uint64_t cachedId = ~std::uint64_t(0);
+        thread_local Shard *cached = nullptr;
+        if (cachedId == id) {
+            return *cached;
+        }
+        const std::thread::id self = std::this_thread::get_id();
+        Shard *shard = head.load(std::memory_order_acquire);
+        while (shard != nullptr && shard->owner != self) {
+            shard = shard->next;
+        }
+        if (shard == nullptr) {
+            shard = new Shard(names, fields);
+            shard->next = head.load(std::memory_order_relaxed);
+            while (!head.compare_exchange_weak(shard->next, shard, std::memory_order_release,
+                                               std::memory_order_relaxed)) {}
+        }
+        cachedId = id;
+        cached = shard;
+        return *shard;
+    }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef WORLDCUP_MARKOV_H
+#define WORLDCUP_MARKOV_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <numeric>
+#include <vector>
+
+#include "worldcup2022.h"
+
+// Długookresowe częstości odwiedzin pól planszy przez jednego gracza.
+// Wszystkie wielkości są liczone na turę (łącznie z turami czekania).
+struct VisitFrequencies {
+    struct Square {
+        // Prawdopodobieństwo, że tura kończy się zatrzymaniem na polu.
+        double stop = 0.0;
+        // Oczekiwana liczba przejść przez pole w turze.
+        double pass = 0.0;
+        // Prawdopodobieństwo, że gracz zaczyna turę na polu (także czekając).
+        double occupancy = 0.0;
+        // Oczekiwana zmiana salda gracza w turze przypisana polu.
+        double money = 0.0;
+    };
+
+    std::vector<Square> squares;
+    // Oczekiwana liczba tur na jeden ruch (kary wydłużają ruch o czekanie).
+    double turnsPerMove = 1.0;
+    // Oczekiwana zmiana salda gracza w turze.
+    double moneyPerTurn = 0.0;
+};
+
+// Rozwiązuje łańcuch Markowa pozycji gracza o stanach (pole, pozostałe
+// czekanie) dla danego rozkładu sumy oczek (zob. sumDistribution()).
+//
+// Żadne pole nie przesuwa gracza, więc przejście z pola j na pole s zależy
+// tylko od (s - j) mod n: macierz przejść ruchów jest cyrkulantem, a więc
+// podwójnie stochastyczna. Rozkład stacjonarny ruchów jest zatem jednostajny
+// na polach osiągalnych z pola startowego (wielokrotności g = nwd(n, możliwe
+// rzuty)), a stany czekania żółtej kartki tylko wydłużają ruch o stałą liczbę
+// tur. Dzięki temu rozwiązanie jest dokładne i kosztuje O(n + maksymalny
+// rzut), podczas gdy iteracja potęgowa na planszy o 10 tys. pól zbiegałaby
+// w czasie rzędu n^2 / wariancja rzutu iteracji.
+//
+// Przepływ pieniędzy pomija bankructwa i zaokrąglenia wypłat meczów: pula
+// meczu jest w całości wypłacana z wagą meczu, a bukmacher wypłaca stawkę
+// co frequency-ty raz (licznik jest wspólny dla wszystkich graczy, więc
+// w długim okresie dotyczy to także pojedynczego gracza).
+class VisitSolver {
+public:
+    class InvalidDistributionException : public std::exception {};
+
+    VisitSolver(std::vector<SquareSpec> layout, std::vector<double> sumWeights) :
+                layout(std::move(layout)), weights(std::move(sumWeights)) {
+        double total = 0.0;
+        for (double w : weights) {
+            if (w < 0.0) {
+                throw InvalidDistributionException();
+            }
+            total += w;
+        }
+        if (total <= 0.0 || this->layout.empty()) {
+            throw InvalidDistributionException();
+        }
+        for (double &w : weights) {
+            w /= total;
+        }
+    }
+
+    [[nodiscard]] VisitFrequencies solve() const {
+        const std::size_t n = layout.size();
+        std::size_t period = n;
+        for (std::size_t roll = 0; roll < weights.size(); roll++) {
+            if (weights[roll] > 0.0) {
+                period = std::gcd(period, roll % n);
+            }
+        }
+        const double perMove = static_cast<double>(period) / static_cast<double>(n);
+
+        // Gracz przechodzi przez pole odległe o d od pola startowego, jeśli
+        // wyrzuci więcej niż d. Przy jednostajnym rozkładzie na polach
+        // osiągalnych liczba przejść zależy tylko od reszty pola modulo g.
+        std::vector<double> passByResidue(period, 0.0);
+        double tail = 1.0 - weights[0];
+        for (std::size_t d = 1; d < weights.size(); d++) {
+            tail -= weights[d];
+            passByResidue[d % period] += std::max(tail, 0.0);
+        }
+
+        VisitFrequencies result;
+        result.squares.resize(n);
+        for (std::size_t s = 0; s < n; s++) {
+            VisitFrequencies::Square &square = result.squares[s];
+            square.stop = s % period == 0 ? perMove : 0.0;
+            square.pass = passByResidue[s % period] * perMove;
+            result.turnsPerMove += square.stop * waiting(layout[s]);
+        }
+        for (std::size_t s = 0; s < n; s++) {
+            VisitFrequencies::Square &square = result.squares[s];
+            square.occupancy = square.stop * (1.0 + waiting(layout[s]));
+            square.money = flow(layout[s], square.stop, square.pass);
+            square.stop /= result.turnsPerMove;
+            square.pass /= result.turnsPerMove;
+            square.occupancy /= result.turnsPerMove;
+            square.money /= result.turnsPerMove;
+            result.moneyPerTurn += square.money;
+        }
+        return result;
+    }
+
+private:
+    std::vector<SquareSpec> layout;
+    std::vector<double> weights;
+
+    static double waiting(const SquareSpec &spec) {
+        if (spec.kind != SquareSpec::yellowCard || spec.amount == 0) {
+            return 0.0;
+        }
+        return spec.amount - 1.0;
+    }
+
+    static double flow(const SquareSpec &spec, double stop, double pass) {
+        const double amount = spec.amount;
+        switch (spec.kind) {
+            case SquareSpec::seasonBeginning:
+                return amount * (stop + pass);
+            case SquareSpec::goal:
+                return amount * stop;
+            case SquareSpec::penalty:
+                return -amount * stop;
+            case SquareSpec::bookmaker: {
+                const double frequency = std::max(spec.frequency, 1u);
+                return amount * stop * (2.0 - frequency) / frequency;
+            }
+            case SquareSpec::match:
+                return amount * pass * (spec.rate - 1.0);
+            case SquareSpec::yellowCard:
+            case SquareSpec::freeDay:
+            case SquareSpec::custom:
+                break;
+        }
+        return 0.0;
+    }
+};
+
+#endif
@@ -0,0 +1,418 @@
+#ifndef WORLDCUP_MCTS_H
+#define WORLDCUP_MCTS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "worldcup2022.h"
+
+// Zwarta, kopiowalna wartościowo kopia stanu rozgrywki, na której agent
+// rozgrywa tysiące symulacji na decyzję. Stosuje te same reguły co
+// WorldCup2022 do pól opisanych przez SquareSpec; zależne od zasad premia
+// startowa i częstość wygranych bukmachera są zapisane w SquareSpec, więc
+// kopia działa z układem planszy każdego wbudowanego wariantu. Pola typu
+// custom (z wtyczek) nie są obsługiwane, bo ich stan żyje poza SquareSpec.
+// Obsługuje co najwyżej MAX_LANES graczy, żeby kopia stanu nie wymagała
+// alokacji na graczy, a przypisanie do istniejącej kopii używa ponownie jej
+// tablicy stanów pól.
+class CompactGame {
+public:
+    static constexpr int NO_WINNER = -1;
+    static constexpr unsigned int MAX_LANES = DefaultRules::maxPlayers;
+    static_assert(ThreeDiceRules::maxPlayers == MAX_LANES && StrictBookmakerRules::maxPlayers == MAX_LANES);
+
+    CompactGame(const std::vector<SquareSpec> &layout, const GameSnapshot &snapshot) :
+                layout(&layout), count(snapshot.ids.size()), fieldState(snapshot.fieldState),
+                current(snapshot.current), round(snapshot.round), rounds(snapshot.rounds) {
+        assert(count <= MAX_LANES);
+        for (unsigned int i = 0; i < count; i++) {
+            lanes[i] = {snapshot.ids[i], snapshot.positions[i], snapshot.money[i], snapshot.suspensions[i]};
+        }
+    }
+
+    [[nodiscard]] bool finished() const {
+        return count <= 1 || round >= rounds;
+    }
+
+    [[nodiscard]] unsigned int currentId() const {
+        return lanes[current].id;
+    }
+
+    [[nodiscard]] bool currentSuspended() const {
+        return lanes[current].suspension > 0;
+    }
+
+    // Rozgrywa turę bieżącego gracza; roll jest ignorowany, jeśli gracz
+    // czeka albo odpuszcza ruch.
+    void turn(bool sitOut, unsigned int roll) {
+        Lane &player = lanes[current];
+        bool bankrupt = false;
+        if (player.suspension > 0) {
+            player.suspension--;
+        } else if (!sitOut) {
+            move(player, roll, bankrupt);
+        }
+        if (bankrupt) {
+            for (unsigned int i = current + 1; i < count; i++) {
+                lanes[i - 1] = lanes[i];
+            }
+            count--;
+        } else {
+            current++;
+        }
+        if (current >= count) {
+            current = 0;
+            round++;
+        }
+    }
+
+    [[nodiscard]] int winnerId() const {
+        if (count == 1) {
+            return static_cast<int>(lanes[0].id);
+        }
+        int winner = NO_WINNER;
+        unsigned int best = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            if (lanes[i].money > best) {
+                best = lanes[i].money;
+                winner = static_cast<int>(lanes[i].id);
+            }
+        }
+        return winner;
+    }
+
+    [[nodiscard]] std::uint64_t hash() const {
+        std::uint64_t h = mix(0x9e3779b97f4a7c15ull ^ round);
+        h = mix(h ^ current);
+        h = mix(h ^ count);
+        for (unsigned int i = 0; i < count; i++) {
+            h = mix(h ^ lanes[i].id);
+            h = mix(h ^ lanes[i].position);
+            h = mix(h ^ lanes[i].money);
+            h = mix(h ^ lanes[i].suspension);
+        }
+        for (unsigned int state : fieldState) {
+            h = mix(h ^ state);
+        }
+        return h;
+    }
+
+private:
+    struct Lane {
+        unsigned int id;
+        unsigned int position;
+        unsigned int money;
+        unsigned int suspension;
+    };
+
+    const std::vector<SquareSpec> *layout;
+    std::array<Lane, MAX_LANES> lanes{};
+    unsigned int count;
+    std::vector<unsigned int> fieldState;
+    unsigned int current;
+    unsigned int round;
+    unsigned int rounds;
+
+    static std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    static unsigned int subtract(Lane &player, unsigned int amount, bool &bankrupt) {
+        if (player.money >= amount) {
+            player.money -= amount;
+            return amount;
+        }
+        bankrupt = true;
+        unsigned int paid = player.money;
+        player.money = 0;
+        return paid;
+    }
+
+    void move(Lane &player, unsigned int roll, bool &bankrupt) {
+        const auto size = static_cast<unsigned int>(layout->size());
+        for (unsigned int i = 1; i < roll && !bankrupt; i++) {
+            unsigned int square = (player.position + i) % size;
+            const SquareSpec &spec = (*layout)[square];
+            if (spec.kind == SquareSpec::seasonBeginning) {
+                player.money += spec.amount;
+            } else if (spec.kind == SquareSpec::match) {
+                fieldState[square] += subtract(player, spec.amount, bankrupt);
+            }
+        }
+        player.position = (player.position + roll) % size;
+        if (bankrupt) {
+            return;
+        }
+        const SquareSpec &spec = (*layout)[player.position];
+        unsigned int &state = fieldState[player.position];
+        switch (spec.kind) {
+            case SquareSpec::seasonBeginning:
+            case SquareSpec::goal:
+                player.money += spec.amount;
+                break;
+            case SquareSpec::penalty:
+                subtract(player, spec.amount, bankrupt);
+                break;
+            case SquareSpec::bookmaker:
+                if (state == 0) {
+                    player.money += spec.amount;
+                } else {
+                    subtract(player, spec.amount, bankrupt);
+                }
+                state = (state + 1) % std::max(spec.frequency, 1u);
+                break;
+            case SquareSpec::yellowCard:
+                player.suspension += spec.amount - 1;
+                break;
+            case SquareSpec::match:
+                player.money += static_cast<unsigned int>(static_cast<float>(state) * spec.rate);
+                state = 0;
+                break;
+            case SquareSpec::freeDay:
+            case SquareSpec::custom:
+                break;
+        }
+    }
+};
+
+// Agent wybierający, czy odpuścić turę, metodą Monte Carlo Tree Search.
+// Drzewo jest przechowywane we wspólnej tablicy transpozycji indeksowanej
+// skrótem stanu w chwilach decyzji agenta (między nimi losowane są rzuty, więc
+// jest to wariant "open loop"). Wątki przeszukują równolegle; wybór akcji
+// dolicza jej wirtualną porażkę do czasu propagacji wyniku, żeby wątki nie
+// schodziły tą samą ścieżką. Wpisy są oznaczone numerem decyzji, w której
+// powstały, a wpisy z wcześniejszych decyzji są traktowane jak wolne, więc
+// długo żyjący agent nie zapełnia tablicy. Decyzje (sitOut) jednego agenta
+// nie mogą przebiegać współbieżnie.
+class MctsAgent : public TurnAgent {
+public:
+    // Plansza zawiera pola z wtyczek, których symulacje nie odtworzą.
+    class UnsupportedLayoutException : public std::exception {};
+
+    struct Settings {
+        unsigned int iterations = 2000;
+        unsigned int threads = 1;
+        double exploration = 1.4;
+        // Tablica ma 2^tableBits wpisów.
+        unsigned int tableBits = 16;
+        std::uint64_t seed = 0;
+    };
+
+    // sumWeights to rozkład sumy oczek (zob. sumDistribution()).
+    MctsAgent(std::vector<SquareSpec> layout, const std::vector<double> &sumWeights, Settings settings) :
+              layout(std::move(layout)), rolls(sumWeights), settings(settings),
+              table(std::make_unique<Entry[]>(std::size_t(1) << settings.tableBits)),
+              mask((std::size_t(1) << settings.tableBits) - 1) {
+        for (const SquareSpec &spec : this->layout) {
+            if (spec.kind == SquareSpec::custom) {
+                throw UnsupportedLayoutException();
+            }
+        }
+    }
+
+    MctsAgent(std::vector<SquareSpec> layout, const std::vector<double> &sumWeights) :
+              MctsAgent(std::move(layout), sumWeights, Settings()) {}
+
+    bool sitOut(const GameSnapshot &snapshot) override {
+        if (snapshot.ids.size() > CompactGame::MAX_LANES) {
+            return false;
+        }
+        const CompactGame root(layout, snapshot);
+        const unsigned int me = root.currentId();
+        generation = decisions.fetch_add(1) + 1;
+
+        unsigned int threads = std::max(settings.threads, 1u);
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < threads; t++) {
+            workers.emplace_back(&MctsAgent::search, this, std::cref(root), me, t,
+                                 settings.iterations / threads);
+        }
+        search(root, me, 0, settings.iterations - settings.iterations / threads * (threads - 1));
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+
+        Entry *entry = find(root.hash(), false);
+        for (unsigned int a = 0; a < 2; a++) {
+            lastVisits[a] = entry != nullptr ? entry->visits[a].load() : 0;
+        }
+        return lastVisits[SIT_OUT] > lastVisits[ROLL];
+    }
+
+    // Liczba podjętych decyzji.
+    [[nodiscard]] std::uint64_t decisionCount() const {
+        return decisions.load();
+    }
+
+    // Odwiedziny korzenia w ostatniej decyzji: rzut i odpuszczenie tury.
+    [[nodiscard]] std::array<std::uint32_t, 2> lastRootVisits() const {
+        return lastVisits;
+    }
+
+private:
+    static constexpr unsigned int ROLL = 0;
+    static constexpr unsigned int SIT_OUT = 1;
+    static constexpr unsigned int PROBES = 16;
+    // Klucze są nieparzyste, więc parzysta wartość oznacza wpis zajmowany
+    // właśnie przez inny wątek.
+    static constexpr std::uint64_t CLAIMING = 2;
+
+    struct Entry {
+        std::atomic<std::uint64_t> key = 0;
+        // Numer decyzji, w której wpis powstał (0: nigdy nieużywany).
+        std::atomic<std::uint64_t> generation = 0;
+        std::array<std::atomic<std::uint32_t>, 2> visits{};
+        std::array<std::atomic<std::uint32_t>, 2> wins{};
+        std::array<std::atomic<std::uint32_t>, 2> virtualLoss{};
+    };
+
+    std::vector<SquareSpec> layout;
+    AliasTable rolls;
+    Settings settings;
+    std::unique_ptr<Entry[]> table;
+    std::size_t mask;
+    std::atomic<std::uint64_t> decisions = 0;
+    // Numer bieżącej decyzji; zmieniany tylko przed uruchomieniem wątków.
+    std::uint64_t generation = 0;
+    std::array<std::uint32_t, 2> lastVisits{};
+
+    // Klucz wpisu z bieżącej decyzji, CLAIMING dla wpisu w trakcie zajmowania
+    // albo 0 dla wpisu wolnego (także z wcześniejszej decyzji). Klucz jest
+    // czytany przed i po numerze decyzji, bo zajmujący ustawia CLAIMING przed
+    // zmianą numeru, a nowy klucz dopiero po niej.
+    std::uint64_t currentKey(const Entry &entry) const {
+        for (;;) {
+            std::uint64_t before = entry.key.load(std::memory_order_acquire);
+            std::uint64_t stored = entry.generation.load(std::memory_order_acquire);
+            if (before == CLAIMING) {
+                return CLAIMING;
+            }
+            if (entry.key.load(std::memory_order_acquire) == before) {
+                return stored == generation ? before : 0;
+            }
+        }
+    }
+
+    // Wyszukuje (i opcjonalnie wstawia) wpis stanu; zwraca nullptr, gdy
+    // wszystkie sprawdzane miejsca są zajęte przez inne stany bieżącej decyzji.
+    Entry *find(std::uint64_t key, bool insert) {
+        key |= 1;
+        for (unsigned int probe = 0; probe < PROBES; probe++) {
+            Entry &entry = table[(key + probe) & mask];
+            std::uint64_t current = currentKey(entry);
+            while (current == CLAIMING) {
+                std::this_thread::yield();
+                current = currentKey(entry);
+            }
+            if (current == key) {
+                return &entry;
+            }
+        }
+        if (!insert) {
+            return nullptr;
+        }
+        // Stanu nie ma, więc zajmujemy pierwsze wolne miejsce. Wątek, który
+        // przegra wyścig o to miejsce, czeka na jego klucz i sprawdza je ponownie.
+        for (unsigned int probe = 0; probe < PROBES; probe++) {
+            Entry &entry = table[(key + probe) & mask];
+            for (;;) {
+                std::uint64_t stored = entry.key.load(std::memory_order_acquire);
+                std::uint64_t current = currentKey(entry);
+                if (current == CLAIMING) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (current == key) {
+                    return &entry;
+                }
+                if (current != 0) {
+                    break;
+                }
+                if (stored != CLAIMING &&
+                    entry.key.compare_exchange_strong(stored, CLAIMING, std::memory_order_acq_rel)) {
+                    for (unsigned int a = 0; a < 2; a++) {
+                        entry.visits[a].store(0, std::memory_order_relaxed);
+                        entry.wins[a].store(0, std::memory_order_relaxed);
+                        entry.virtualLoss[a].store(0, std::memory_order_relaxed);
+                    }
+                    entry.generation.store(generation, std::memory_order_release);
+                    entry.key.store(key, std::memory_order_release);
+                    return &entry;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    unsigned int select(const Entry &entry) const {
+        double n[2];
+        for (unsigned int a = 0; a < 2; a++) {
+            n[a] = entry.visits[a].load(std::memory_order_relaxed) + entry.virtualLoss[a].load(std::memory_order_relaxed);
+            if (n[a] == 0) {
+                return a;
+            }
+        }
+        double logTotal = std::log(n[0] + n[1]);
+        double best = -1.0;
+        unsigned int choice = ROLL;
+        for (unsigned int a = 0; a < 2; a++) {
+            double score = entry.wins[a].load(std::memory_order_relaxed) / n[a] +
+                           settings.exploration * std::sqrt(logTotal / n[a]);
+            if (score > best) {
+                best = score;
+                choice = a;
+            }
+        }
+        return choice;
+    }
+
+    void search(const CompactGame &root, unsigned int me, unsigned int thread, unsigned int iterations) {
+        std::mt19937_64 random(settings.seed ^ (decisions.load() << 20) ^ (std::uint64_t(thread) << 48));
+        std::vector<std::pair<Entry *, unsigned int>> path;
+        // Jedna kopia na wątek: przypisanie nie alokuje tablicy stanów pól.
+        CompactGame game = root;
+        for (unsigned int i = 0; i < iterations; i++) {
+            game = root;
+            bool inTree = true;
+            path.clear();
+            while (!game.finished()) {
+                bool sitOut = false;
+                if (inTree && game.currentId() == me && !game.currentSuspended()) {
+                    Entry *entry = find(game.hash(), true);
+                    if (entry == nullptr) {
+                        inTree = false;
+                    } else {
+                        unsigned int action = select(*entry);
+                        // Pierwsza wizyta w akcji rozszerza drzewo; dalej
+                        // gra toczy się domyślną polityką (zawsze rzut).
+                        inTree = entry->visits[action].load(std::memory_order_relaxed) > 0;
+                        entry->virtualLoss[action].fetch_add(1, std::memory_order_relaxed);
+                        path.emplace_back(entry, action);
+                        sitOut = action == SIT_OUT;
+                    }
+                }
+                game.turn(sitOut, game.currentSuspended() || sitOut ? 0 : rolls.sample(random()));
+            }
+            std::uint32_t reward = game.winnerId() == static_cast<int>(me) ? 1 : 0;
+            for (auto [entry, action] : path) {
+                entry->visits[action].fetch_add(1, std::memory_order_relaxed);
+                entry->wins[action].fetch_add(reward, std::memory_order_relaxed);
+                entry->virtualLoss[action].fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+#endif
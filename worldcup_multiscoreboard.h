@@ -0,0 +1,88 @@
+#ifndef WORLDCUP_MULTISCOREBOARD_H
+#define WORLDCUP_MULTISCOREBOARD_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "worldcup.h"
+
+// Tablica wyników rozsyłająca każde zdarzenie do wielu tablic-odbiorców.
+// Odbiorca przy rejestracji deklaruje interesujące go zdarzenia; odbiorcy są
+// od razu rozdzielani na osobne listy, więc zdarzenie, którego nikt nie
+// subskrybuje, kosztuje tylko sprawdzenie pustej listy. Napisy ze stanem
+// gracza i nazwą pola powstają raz w silniku i są przekazywane wszystkim
+// odbiorcom przez referencję.
+class MultiScoreBoard : public ScoreBoard {
+public:
+    enum Events : unsigned int {
+        rounds = 1,
+        turns = 2,
+        // Tylko te tury, w których stan gracza różni się od poprzedniego.
+        statusChanges = 4,
+        wins = 8,
+        all = rounds | turns | wins
+    };
+
+    void addScoreBoard(std::shared_ptr<ScoreBoard> sink, unsigned int events = all) {
+        if (sink == nullptr) {
+            return;
+        }
+        if (events & rounds) {
+            roundSinks.push_back(sink);
+        }
+        if (events & turns) {
+            turnSinks.push_back(sink);
+        } else if (events & statusChanges) {
+            changeSinks.push_back(sink);
+        }
+        if (events & wins) {
+            winSinks.push_back(sink);
+        }
+    }
+
+    void onRound(unsigned int roundNo) override {
+        if (roundNo == 0) {
+            lastStatus.clear();
+        }
+        for (const auto &sink : roundSinks) {
+            sink->onRound(roundNo);
+        }
+    }
+
+    void onTurn(std::string const &playerName, std::string const &playerStatus,
+                std::string const &squareName, unsigned int money) override {
+        for (const auto &sink : turnSinks) {
+            sink->onTurn(playerName, playerStatus, squareName, money);
+        }
+        if (changeSinks.empty()) {
+            return;
+        }
+        auto [it, inserted] = lastStatus.try_emplace(playerName, playerStatus);
+        if (!inserted) {
+            if (it->second == playerStatus) {
+                return;
+            }
+            it->second = playerStatus;
+        }
+        for (const auto &sink : changeSinks) {
+            sink->onTurn(playerName, playerStatus, squareName, money);
+        }
+    }
+
+    void onWin(std::string const &playerName) override {
+        for (const auto &sink : winSinks) {
+            sink->onWin(playerName);
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<ScoreBoard>> roundSinks;
+    std::vector<std::shared_ptr<ScoreBoard>> turnSinks;
+    std::vector<std::shared_ptr<ScoreBoard>> changeSinks;
+    std::vector<std::shared_ptr<ScoreBoard>> winSinks;
+    std::unordered_map<std::string, std::string> lastStatus;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef WORLDCUP_PLUGIN_H
+#define WORLDCUP_PLUGIN_H
+
+#include <cstddef>
+#include <string>
+
+// Gracz widziany przez pole z wtyczki: tylko stan konta i zawieszenie.
+// Odwołuje się bezpośrednio do pamięci gracza (albo toru w partii).
+class FieldPlayer {
+private:
+    unsigned int &zdzislaws;
+    int &suspension;
+    bool &isBankrupt;
+
+public:
+    FieldPlayer(unsigned int &money, int &suspension, bool &bankrupt) :
+                zdzislaws(money), suspension(suspension), isBankrupt(bankrupt) {}
+
+    [[nodiscard]] unsigned int money() const {
+        return zdzislaws;
+    }
+
+    [[nodiscard]] bool bankrupt() const {
+        return isBankrupt;
+    }
+
+    void addMoney(unsigned int amount) {
+        zdzislaws += amount;
+    }
+
+    // Jak w silniku: gracza, którego nie stać, zeruje i ogłasza bankrutem.
+    // Zwraca faktycznie pobraną kwotę.
+    unsigned int subtractMoney(unsigned int amount) {
+        if (zdzislaws >= amount) {
+            zdzislaws -= amount;
+            return amount;
+        }
+        isBankrupt = true;
+        unsigned int paid = zdzislaws;
+        zdzislaws = 0;
+        return paid;
+    }
+
+    // Gracz opuści podaną liczbę kolejnych tur.
+    void suspend(unsigned int turns) {
+        suspension += static_cast<int>(turns);
+    }
+};
+
+// Partia graczy (np. ten sam gracz w wielu równoległych grach albo wielu
+// graczy naraz) w układzie struktury tablic: i-ty tor to i-te elementy tablic.
+struct FieldLanes {
+    std::size_t count = 0;
+    unsigned int *money = nullptr;
+    int *suspension = nullptr;
+    bool *bankrupt = nullptr;
+
+    [[nodiscard]] FieldPlayer operator[](std::size_t lane) const {
+        return {money[lane], suspension[lane], bankrupt[lane]};
+    }
+};
+
+// Pole planszy dostarczane z zewnątrz, np. z biblioteki współdzielonej
+// (zob. FieldPluginLibrary w worldcup_plugin_library.h). Każda plansza potrzebuje własnej instancji, bo
+// pole może mieć stan (jak pula meczu).
+//
+// Silnik rusza graczy pojedynczo i woła onPlayerStop/onPlayerPass. Symulatory
+// przetwarzające wiele torów naraz wołają wersje partiami; domyślnie przechodzą
+// one po torach i wołają wersje pojedyncze, a wtyczka może je nadpisać, żeby
+// obsłużyć całą partię jednym wywołaniem wirtualnym.
+class FieldPlugin {
+public:
+    virtual ~FieldPlugin() = default;
+
+    [[nodiscard]] virtual std::string name() const = 0;
+
+    virtual void onPlayerStop([[maybe_unused]] FieldPlayer &player) {}
+    virtual void onPlayerPass([[maybe_unused]] FieldPlayer &player) {}
+    virtual void reset() {}
+
+    virtual void onPlayersStop(const FieldLanes &lanes) {
+        for (std::size_t lane = 0; lane < lanes.count; lane++) {
+            FieldPlayer player = lanes[lane];
+            onPlayerStop(player);
+        }
+    }
+
+    virtual void onPlayersPass(const FieldLanes &lanes) {
+        for (std::size_t lane = 0; lane < lanes.count; lane++) {
+            FieldPlayer player = lanes[lane];
+            onPlayerPass(player);
+        }
+    }
+};
+
+// Biblioteka współdzielona eksportuje pola przez WORLDCUP_FIELD_PLUGIN(Typ),
+// gdzie Typ ma konstruktor przyjmujący napis z konfiguracją pola. Wyjątek
+// z konstruktora kończy się PluginLoadException po stronie wczytującego.
+#define WORLDCUP_FIELD_PLUGIN(Type)                                             \
+    extern "C" FieldPlugin *worldcup_create_field(const char *argument) {       \
+        try {                                                                   \
+            return new Type(std::string(argument));                             \
+        } catch (...) {                                                         \
+            return nullptr;                                                     \
+        }                                                                       \
+    }                                                                           \
+    extern "C" void worldcup_destroy_field(FieldPlugin *plugin) {               \
+        delete plugin;                                                          \
+    }
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef WORLDCUP_PLUGIN_LIBRARY_H
+#define WORLDCUP_PLUGIN_LIBRARY_H
+
+#include <exception>
+#include <memory>
+#include <string>
+
+#include <dlfcn.h>
+
+#include "worldcup_plugin.h"
+
+// Wczytana biblioteka z polami. Pola są tworzone i niszczone przez funkcje
+// biblioteki, a biblioteka pozostaje wczytana, dopóki żyje któreś z jej pól.
+class FieldPluginLibrary {
+public:
+    class PluginLoadException : public std::exception {};
+
+    explicit FieldPluginLibrary(const std::string &path) {
+        void *opened = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (opened == nullptr) {
+            throw PluginLoadException();
+        }
+        handle = std::shared_ptr<void>(opened, ::dlclose);
+        create = reinterpret_cast<Create>(::dlsym(opened, "worldcup_create_field"));
+        destroy = reinterpret_cast<Destroy>(::dlsym(opened, "worldcup_destroy_field"));
+        if (create == nullptr || destroy == nullptr) {
+            throw PluginLoadException();
+        }
+    }
+
+    [[nodiscard]] std::shared_ptr<FieldPlugin> field(const std::string &argument = "") const {
+        FieldPlugin *plugin = create(argument.c_str());
+        if (plugin == nullptr) {
+            throw PluginLoadException();
+        }
+        return {plugin, [destroy = destroy, library = handle](FieldPlugin *p) { destroy(p); }};
+    }
+
+private:
+    using Create = FieldPlugin *(*)(const char *);
+    using Destroy = void (*)(FieldPlugin *);
+
+    std::shared_ptr<void> handle;
+    Create create = nullptr;
+    Destroy destroy = nullptr;
+};
+
+#endif
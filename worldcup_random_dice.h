@@ -0,0 +1,124 @@
+#ifndef WORLDCUP_RANDOM_DICE_H
+#define WORLDCUP_RANDOM_DICE_H
+
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "worldcup_dice.h"
+
+// Kostka losowa o zadanym rozkładzie i ziarnie; powtarzalna dla tego samego
+// ziarna. Rzut jest operacją const, więc generator jest mutable. Silnik losuje
+// sumę z faceWeights() zamiast wołać roll(), więc obie metody są final:
+// podklasa z innym rzutem byłaby po cichu pominięta.
+class RandomDie : public DistributionDie {
+protected:
+    std::vector<double> weights;
+    mutable std::mt19937_64 engine;
+    mutable std::discrete_distribution<unsigned short> distribution;
+
+public:
+    explicit RandomDie(std::vector<double> weights, std::uint64_t seed = 0) :
+                       weights(std::move(weights)), engine(seed),
+                       distribution(this->weights.begin(), this->weights.end()) {}
+
+    [[nodiscard]] unsigned short roll() const final {
+        return distribution(engine);
+    }
+
+    [[nodiscard]] const std::vector<double> &faceWeights() const final {
+        return weights;
+    }
+
+    [[nodiscard]] std::uint64_t nextRandom() const override {
+        return engine();
+    }
+
+    void seed(std::uint64_t seed) {
+        engine.seed(seed);
+        distribution.reset();
+    }
+};
+
+// Iloraz wiarygodności p/q jednej rozgrywki, trzymany jako logarytm, żeby
+// długie gry nie kończyły się niedomiarem.
+class LikelihoodRatio {
+private:
+    double logWeight = 0.0;
+
+public:
+    void reset() {
+        logWeight = 0.0;
+    }
+
+    void add(double logRatio) {
+        logWeight += logRatio;
+    }
+
+    [[nodiscard]] double weight() const {
+        return std::exp(logWeight);
+    }
+};
+
+// Kostka losująca z rozkładu zaburzonego q zamiast nominalnego p i dopisująca
+// log(p/q) każdego rzutu do wspólnego ilorazu wiarygodności gry. Celowo nie
+// jest DistributionDie: każdy rzut musi przejść przez roll(). Rozkład q musi
+// dopuszczać każdy wynik możliwy przy p, inaczej estymator byłby obciążony.
+class TiltedDie : public Die {
+private:
+    RandomDie sampler;
+    std::vector<double> logRatios;
+    std::shared_ptr<LikelihoodRatio> ratio;
+
+public:
+    class UncoveredOutcomeException : public std::exception {};
+
+    TiltedDie(const std::vector<double> &nominal, std::vector<double> proposal,
+              std::shared_ptr<LikelihoodRatio> ratio, std::uint64_t seed = 0) :
+              sampler(std::move(proposal), seed), logRatios(sampler.faceWeights().size()),
+              ratio(std::move(ratio)) {
+        const std::vector<double> &weights = sampler.faceWeights();
+        for (std::size_t k = weights.size(); k < nominal.size(); k++) {
+            if (nominal[k] > 0.0) {
+                throw UncoveredOutcomeException();
+            }
+        }
+        double nominalSum = 0.0;
+        double proposalSum = 0.0;
+        for (std::size_t k = 0; k < weights.size(); k++) {
+            nominalSum += k < nominal.size() ? nominal[k] : 0.0;
+            proposalSum += weights[k];
+        }
+        for (std::size_t k = 0; k < weights.size(); k++) {
+            double p = (k < nominal.size() ? nominal[k] : 0.0) / nominalSum;
+            double q = weights[k] / proposalSum;
+            if (q > 0.0) {
+                logRatios[k] = std::log(p / q);
+            } else if (p > 0.0) {
+                throw UncoveredOutcomeException();
+            }
+        }
+    }
+
+    [[nodiscard]] unsigned short roll() const override {
+        unsigned short result = sampler.roll();
+        ratio->add(logRatios[result]);
+        return result;
+    }
+};
+
+// Wykładnicze przechylenie rozkładu: q(k) ~ p(k) * exp(theta * k). Ujemne
+// theta faworyzuje krótkie rzuty, dodatnie długie.
+inline std::vector<double> exponentialTilt(const std::vector<double> &weights, double theta) {
+    std::vector<double> tilted(weights.size());
+    for (std::size_t k = 0; k < weights.size(); k++) {
+        tilted[k] = weights[k] * std::exp(theta * static_cast<double>(k));
+    }
+    return tilted;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef WORLDCUP_SHARDS_H
+#define WORLDCUP_SHARDS_H
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "worldcup_random_dice.h"
+#include "worldcup_simulation.h"
+
+// Zbiorcze wyniki serii gier. Same liczniki całkowite, więc sumowanie
+// kawałków daje ten sam wynik niezależnie od podziału na procesy.
+struct ShardTotals {
+    // Wspólny limit graczy wbudowanych wariantów zasad.
+    static constexpr std::size_t SEATS = DefaultRules::maxPlayers;
+    static_assert(ThreeDiceRules::maxPlayers == SEATS && StrictBookmakerRules::maxPlayers == SEATS);
+
+    std::uint64_t games = 0;
+    std::uint64_t rounds = 0;
+    std::uint64_t noWinner = 0;
+    std::array<std::uint64_t, SEATS> wins{};
+    std::array<std::uint64_t, SEATS> bankruptcies{};
+
+    void add(const GameOutcome &outcome) {
+        games++;
+        rounds += outcome.rounds;
+        if (outcome.winner == GameOutcome::NO_WINNER) {
+            noWinner++;
+        } else {
+            wins[outcome.winner]++;
+        }
+        for (std::size_t seat = 0; seat < outcome.bankruptcyRound.size(); seat++) {
+            if (outcome.bankruptcyRound[seat] != GameOutcome::NOT_BANKRUPT) {
+                bankruptcies[seat]++;
+            }
+        }
+    }
+
+    void merge(const ShardTotals &other) {
+        games += other.games;
+        rounds += other.rounds;
+        noWinner += other.noWinner;
+        for (std::size_t seat = 0; seat < SEATS; seat++) {
+            wins[seat] += other.wins[seat];
+            bankruptcies[seat] += other.bankruptcies[seat];
+        }
+    }
+
+    bool operator==(const ShardTotals &) const = default;
+};
+
+// Rozgrywa serię gier w wielu procesach potomnych (fork), każdy na rozłącznym
+// przedziale ziaren. Gra o ziarnie s zawsze używa kostek zasianych
+// wyprowadzonymi z s wartościami, więc jej wynik nie zależy od tego, który
+// proces ją rozegrał. Procesy zapisują wyniki do własnych slotów we wspólnym
+// anonimowym segmencie pamięci, a rodzic scala sloty po kolei. Każdy proces
+// gra według zasad wybranego wariantu, z tyloma kostkami, ile one wymagają.
+class ShardedSimulation {
+public:
+    class TooManyPlayersException : public std::exception {};
+    class ShardFailedException : public std::exception {};
+
+    ShardedSimulation(std::vector<std::string> players, unsigned int rounds,
+                      std::vector<double> dieWeights = fairDieWeights(6),
+                      RuleVariant variant = RuleVariant::standard) :
+                      players(std::move(players)), rounds(rounds), dieWeights(std::move(dieWeights)),
+                      variant(variant) {
+        if (this->players.size() > ShardTotals::SEATS) {
+            throw TooManyPlayersException();
+        }
+    }
+
+    // Rozgrywa gry o ziarnach [firstSeed, firstSeed + games).
+    ShardTotals run(std::uint64_t firstSeed, std::uint64_t games, unsigned int workers) {
+        if (workers == 0) {
+            workers = 1;
+        }
+        std::size_t bytes = sizeof(ShardTotals) * workers;
+        void *shared = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (shared == MAP_FAILED) {
+            throw ShardFailedException();
+        }
+        auto *slots = static_cast<ShardTotals *>(shared);
+        for (unsigned int w = 0; w < workers; w++) {
+            new (&slots[w]) ShardTotals();
+        }
+
+        std::vector<pid_t> children;
+        bool failed = false;
+        for (unsigned int w = 0; w < workers && !failed; w++) {
+            std::uint64_t begin = firstSeed + games * w / workers;
+            std::uint64_t end = firstSeed + games * (w + 1) / workers;
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                int status = 0;
+                try {
+                    runRange(begin, end, slots[w]);
+                } catch (...) {
+                    status = 1;
+                }
+                ::_exit(status);
+            }
+            if (pid < 0) {
+                failed = true;
+            } else {
+                children.push_back(pid);
+            }
+        }
+        for (pid_t pid : children) {
+            int status = 0;
+            if (::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed = true;
+            }
+        }
+
+        ShardTotals totals;
+        for (unsigned int w = 0; w < workers; w++) {
+            totals.merge(slots[w]);
+        }
+        ::munmap(shared, bytes);
+        if (failed) {
+            throw ShardFailedException();
+        }
+        return totals;
+    }
+
+private:
+    std::vector<std::string> players;
+    unsigned int rounds;
+    std::vector<double> dieWeights;
+    RuleVariant variant;
+
+    void runRange(std::uint64_t begin, std::uint64_t end, ShardTotals &slot) {
+        dispatchRules(variant, [&](auto rules) {
+            BasicWorldCup<decltype(rules)> engine;
+            std::vector<std::shared_ptr<RandomDie>> dice;
+            for (unsigned int d = 0; d < rules.diesNumber; d++) {
+                dice.push_back(std::make_shared<RandomDie>(dieWeights));
+                engine.addDie(dice.back());
+            }
+            // Wynik jest budowany lokalnie i kopiowany do wspólnej pamięci raz.
+            ShardTotals local;
+            simulateSeededRange(engine, dice, players, rounds, begin, end,
+                                [&local](std::uint64_t, const GameOutcome &outcome) { local.add(outcome); });
+            slot = local;
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef WORLDCUP_SIMULATION_H
+#define WORLDCUP_SIMULATION_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "worldcup2022.h"
+#include "worldcup_random_dice.h"
+
+// Wynik jednej rozgrywki w postaci liczbowej, indeksowany miejscem gracza
+// (kolejnością dodania).
+struct GameOutcome {
+    static constexpr int NO_WINNER = -1;
+    static constexpr unsigned int NOT_BANKRUPT = ~0u;
+
+    int winner = NO_WINNER;
+    unsigned int rounds = 0;
+    std::vector<unsigned int> balances;
+    std::vector<unsigned int> bankruptcyRound;
+};
+
+// Odtwarza GameOutcome z samych zdarzeń tablicy wyników. Tury w rundzie
+// przychodzą w kolejności miejsc graczy pozostających w grze, a bankruci są
+// usuwani dopiero w następnej rundzie, więc kolejna tura zawsze odpowiada
+// kolejnemu miejscu z listy z początku rundy. Początek rundy 0 zaczyna nową
+// grę, więc tę samą tablicę można używać wielokrotnie.
+class OutcomeScoreBoard : public ScoreBoard {
+private:
+    std::vector<std::string> names;
+    unsigned int startingBalance;
+    std::vector<unsigned int> active;
+    unsigned int cursor = 0;
+    GameOutcome result;
+
+public:
+    explicit OutcomeScoreBoard(std::vector<std::string> names,
+                               unsigned int startingBalance = DefaultRules::startingBalance) :
+                               names(std::move(names)), startingBalance(startingBalance) {
+        reset();
+    }
+
+    void reset() {
+        active.clear();
+        for (unsigned int seat = 0; seat < names.size(); seat++) {
+            active.push_back(seat);
+        }
+        cursor = 0;
+        result = GameOutcome();
+        result.balances.assign(names.size(), startingBalance);
+        result.bankruptcyRound.assign(names.size(), GameOutcome::NOT_BANKRUPT);
+    }
+
+    void onRound(unsigned int roundNo) override {
+        if (roundNo == 0) {
+            reset();
+        }
+        std::erase_if(active, [this](unsigned int seat) {
+            return result.bankruptcyRound[seat] != GameOutcome::NOT_BANKRUPT;
+        });
+        cursor = 0;
+        result.rounds = roundNo + 1;
+    }
+
+    void onTurn([[maybe_unused]] std::string const &playerName, std::string const &playerStatus,
+                [[maybe_unused]] std::string const &squareName, unsigned int money) override {
+        if (cursor >= active.size()) {
+            return;
+        }
+        unsigned int seat = active[cursor++];
+        result.balances[seat] = money;
+        if (playerStatus == "*** bankrut ***") {
+            result.bankruptcyRound[seat] = result.rounds - 1;
+        }
+    }
+
+    void onWin(std::string const &playerName) override {
+        result.winner = GameOutcome::NO_WINNER;
+        for (unsigned int seat : active) {
+            if (result.bankruptcyRound[seat] == GameOutcome::NOT_BANKRUPT && names[seat] == playerName &&
+                (result.winner == GameOutcome::NO_WINNER ||
+                 result.balances[seat] > result.balances[result.winner])) {
+                result.winner = static_cast<int>(seat);
+            }
+        }
+    }
+
+    [[nodiscard]] const GameOutcome &outcome() const {
+        return result;
+    }
+};
+
+// Rozgrywa jedną grę na podanym silniku (z dodanymi już kostkami) i zwraca
+// jej wynik. Silnik można używać wielokrotnie.
+template<typename Rules>
+GameOutcome simulateGame(BasicWorldCup<Rules> &engine, const std::vector<std::string> &names,
+                         unsigned int rounds) {
+    auto scoreboard = std::make_shared<OutcomeScoreBoard>(names, Rules::startingBalance);
+    engine.removePlayers();
+    for (const std::string &name : names) {
+        engine.addPlayer(name);
+    }
+    engine.setScoreBoard(scoreboard);
+    engine.play(rounds);
+    return scoreboard->outcome();
+}
+
+// Rozgrywa gry o ziarnach [begin, end) i przekazuje sink(ziarno, wynik) dla
+// każdej z nich. Przed grą o ziarnie s kostka d (dodana już do silnika)
+// dostaje ziarno s * dice.size() + d, więc wynik gry zależy tylko od s,
+// a nie od podziału ziaren między wątki czy procesy.
+template<typename Rules, typename Sink>
+void simulateSeededRange(BasicWorldCup<Rules> &engine, const std::vector<std::shared_ptr<RandomDie>> &dice,
+                         const std::vector<std::string> &players, unsigned int rounds,
+                         std::uint64_t begin, std::uint64_t end, Sink &&sink) {
+    for (std::uint64_t seed = begin; seed < end; seed++) {
+        for (std::size_t d = 0; d < dice.size(); d++) {
+            dice[d]->seed(seed * dice.size() + d);
+        }
+        sink(seed, simulateGame(engine, players, rounds));
+    }
+}
+
+#endif
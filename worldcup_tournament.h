@@ -0,0 +1,250 @@
+#ifndef WORLDCUP_TOURNAMENT_H
+#define WORLDCUP_TOURNAMENT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "worldcup2022.h"
+
+// Turniej złożony z rozgrywek WorldCup2022 (np. faza grupowa i pucharowa).
+// Rozgrywki tworzą DAG: zwycięzcy rozgrywek-dostawców dołączają jako gracze
+// do rozgrywki, która od nich zależy. Rozgrywka trafia do kolejki w chwili,
+// gdy skończy się ostatni z jej dostawców, a wątki wykonawcze podkradają sobie
+// pracę, więc szybko zakończone gry (np. przez wczesne bankructwa) nie
+// blokują pozostałych rdzeni. Wątek bez pracy czeka na zmiennej warunkowej,
+// aż któraś rozgrywka stanie się gotowa (albo turniej się skończy).
+class Tournament {
+public:
+    // Każdy wątek dostaje własny zestaw kostek, bo kostki mogą mieć stan.
+    // Fabryka jest wołana w wątku wywołującym run(), raz na wątek wykonawczy,
+    // przed ich uruchomieniem, więc nie musi być bezpieczna wielowątkowo.
+    using DiceFactory = std::function<std::vector<std::shared_ptr<Die>>()>;
+
+    explicit Tournament(DiceFactory diceFactory) : diceFactory(std::move(diceFactory)) {}
+
+    // Dodaje rozgrywkę i zwraca jej numer. Gracze rozgrywki to podani gracze
+    // oraz zwycięzcy rozgrywek z feeders (w tej kolejności). Dostawcy muszą
+    // być dodani wcześniej.
+    unsigned int addGame(std::vector<std::string> players, std::vector<unsigned int> feeders = {},
+                         unsigned int rounds = 100) {
+        auto id = static_cast<unsigned int>(games.size());
+        for (unsigned int feeder : feeders) {
+            assert(feeder < id);
+            games[feeder].dependents.push_back(id);
+        }
+        games.emplace_back(std::move(players), std::move(feeders), rounds);
+        return id;
+    }
+
+    // Rozgrywa cały turniej na podanej liczbie wątków. Jeśli któraś rozgrywka
+    // rzuci wyjątek, jej zwycięzcą jest pusty napis, a pierwszy wyjątek jest
+    // ponownie rzucany po zakończeniu wszystkich rozgrywek.
+    void run(unsigned int threads) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        queues = std::vector<WorkQueue>(threads);
+        remaining = games.size();
+        queued = 0;
+        error = nullptr;
+        for (unsigned int id = 0; id < games.size(); id++) {
+            games[id].pending = games[id].feeders.size();
+            games[id].winner.clear();
+            if (games[id].feeders.empty()) {
+                queues[id % threads].push(id);
+                queued++;
+            }
+        }
+
+        std::vector<std::vector<std::shared_ptr<Die>>> dice;
+        for (unsigned int w = 0; w < threads; w++) {
+            dice.push_back(diceFactory());
+        }
+        std::vector<std::thread> workers;
+        for (unsigned int w = 1; w < threads; w++) {
+            workers.emplace_back(&Tournament::work, this, w, std::cref(dice[w]));
+        }
+        work(0, dice[0]);
+        for (std::thread &t : workers) {
+            t.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    [[nodiscard]] const std::string &winner(unsigned int game) const {
+        return games[game].winner;
+    }
+
+    [[nodiscard]] unsigned int size() const {
+        return games.size();
+    }
+
+private:
+    struct Game {
+        std::vector<std::string> players;
+        std::vector<unsigned int> feeders;
+        std::vector<unsigned int> dependents;
+        unsigned int rounds;
+        std::atomic<unsigned int> pending = 0;
+        std::string winner;
+
+        Game(std::vector<std::string> players, std::vector<unsigned int> feeders, unsigned int rounds) :
+             players(std::move(players)), feeders(std::move(feeders)), rounds(rounds) {}
+
+        Game(Game &&other) noexcept :
+             players(std::move(other.players)), feeders(std::move(other.feeders)),
+             dependents(std::move(other.dependents)), rounds(other.rounds) {}
+    };
+
+    // Właściciel zdejmuje zadania z końca, złodzieje z początku kolejki.
+    class WorkQueue {
+    private:
+        std::deque<unsigned int> tasks;
+        std::mutex mutex;
+
+    public:
+        WorkQueue() = default;
+        WorkQueue(WorkQueue &&) noexcept {}
+
+        void push(unsigned int task) {
+            std::lock_guard lock(mutex);
+            tasks.push_back(task);
+        }
+
+        bool pop(unsigned int &task) {
+            std::lock_guard lock(mutex);
+            if (tasks.empty()) {
+                return false;
+            }
+            task = tasks.back();
+            tasks.pop_back();
+            return true;
+        }
+
+        bool steal(unsigned int &task) {
+            std::lock_guard lock(mutex);
+            if (tasks.empty()) {
+                return false;
+            }
+            task = tasks.front();
+            tasks.pop_front();
+            return true;
+        }
+    };
+
+    class WinnerScoreBoard : public ScoreBoard {
+    public:
+        std::string winner;
+
+        void onRound([[maybe_unused]] unsigned int roundNo) override {}
+
+        void onTurn([[maybe_unused]] std::string const &playerName,
+                    [[maybe_unused]] std::string const &playerStatus,
+                    [[maybe_unused]] std::string const &squareName,
+                    [[maybe_unused]] unsigned int money) override {}
+
+        void onWin(std::string const &playerName) override {
+            winner = playerName;
+        }
+    };
+
+    DiceFactory diceFactory;
+    std::deque<Game> games;
+    std::vector<WorkQueue> queues;
+    std::atomic<std::size_t> remaining = 0;
+    // Liczba rozgrywek w kolejkach; zwiększana pod idleMutex, żeby czekający
+    // wątek nie przegapił powiadomienia.
+    std::atomic<std::size_t> queued = 0;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    bool nextTask(unsigned int self, unsigned int &task) {
+        if (queues[self].pop(task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        for (unsigned int i = 1; i < queues.size(); i++) {
+            if (queues[(self + i) % queues.size()].steal(task)) {
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void schedule(unsigned int self, unsigned int task) {
+        queues[self].push(task);
+        {
+            std::lock_guard lock(idleMutex);
+            queued.fetch_add(1, std::memory_order_relaxed);
+        }
+        idle.notify_one();
+    }
+
+    void work(unsigned int self, const std::vector<std::shared_ptr<Die>> &dice) {
+        // Silnik, kostki i tablica wyników są tworzone raz na wątek
+        // i używane ponownie we wszystkich rozgrywanych przez niego grach.
+        WorldCup2022 engine;
+        for (const std::shared_ptr<Die> &die : dice) {
+            engine.addDie(die);
+        }
+        auto scoreboard = std::make_shared<WinnerScoreBoard>();
+        engine.setScoreBoard(scoreboard);
+
+        unsigned int task;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!nextTask(self, task)) {
+                std::unique_lock lock(idleMutex);
+                idle.wait(lock, [this] {
+                    return queued.load(std::memory_order_relaxed) > 0 ||
+                           remaining.load(std::memory_order_acquire) == 0;
+                });
+                continue;
+            }
+            playGame(engine, *scoreboard, games[task]);
+            for (unsigned int dependent : games[task].dependents) {
+                if (games[dependent].pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    schedule(self, dependent);
+                }
+            }
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock(idleMutex);
+                idle.notify_all();
+            }
+        }
+    }
+
+    void playGame(WorldCup2022 &engine, WinnerScoreBoard &scoreboard, Game &game) {
+        engine.removePlayers();
+        for (const std::string &name : game.players) {
+            engine.addPlayer(name);
+        }
+        for (unsigned int feeder : game.feeders) {
+            engine.addPlayer(games[feeder].winner);
+        }
+        scoreboard.winner.clear();
+        try {
+            engine.play(game.rounds);
+        } catch (...) {
+            std::lock_guard lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        game.winner = scoreboard.winner;
+    }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef WORLDCUP_TRACE_H
+#define WORLDCUP_TRACE_H
+
+// Opcjonalne śledzenie czasu wykonania silnika. Po zdefiniowaniu
+// WORLDCUP_TRACING makro WORLDCUP_TRACE_SCOPE(name) mierzy czas do końca
+// bieżącego bloku, a trace::dump() zapisuje zebrane odcinki w formacie JSON
+// Chrome trace (do obejrzenia w chrome://tracing lub Perfetto). Bez tej flagi
+// makro rozwija się do pustej instrukcji i nic nie jest kompilowane.
+
+#ifdef WORLDCUP_TRACING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace trace {
+
+    struct Event {
+        const char *name;
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    // Bufor jednego wątku. Zapisuje do niego tylko właściciel, więc nagrywanie
+    // nie wymaga synchronizacji; rejestr jest blokowany jedynie przy pierwszym
+    // użyciu w wątku oraz przy zrzucie.
+    struct Buffer {
+        unsigned int thread;
+        std::vector<Event> events;
+    };
+
+    inline std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    class Registry {
+    private:
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Buffer>> buffers;
+        std::uint64_t ticksAtStart = now();
+        std::chrono::steady_clock::time_point timeAtStart = std::chrono::steady_clock::now();
+
+    public:
+        static Registry &instance() {
+            static Registry registry;
+            return registry;
+        }
+
+        Buffer &local() {
+            thread_local std::shared_ptr<Buffer> buffer = [this] {
+                std::lock_guard lock(mutex);
+                auto created = std::make_shared<Buffer>();
+                created->thread = buffers.size() + 1;
+                created->events.reserve(1 << 16);
+                buffers.push_back(created);
+                return created;
+            }();
+            return *buffer;
+        }
+
+        // Zapisuje wszystkie odcinki; wątki nie powinny w tym czasie nagrywać.
+        void dump(const std::string &path) {
+            std::lock_guard lock(mutex);
+            auto elapsed = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - timeAtStart).count();
+            std::uint64_t ticks = now() - ticksAtStart;
+            double ticksPerMicro = elapsed > 0 && ticks > 0 ? static_cast<double>(ticks) / elapsed : 1.0;
+            // Rejestr powstaje dopiero przy zamknięciu pierwszego odcinka, więc
+            // odcinki otwarte wcześniej zaczynają się przed ticksAtStart.
+            std::uint64_t origin = ticksAtStart;
+            for (const auto &buffer : buffers) {
+                for (const Event &e : buffer->events) {
+                    origin = std::min(origin, e.begin);
+                }
+            }
+
+            std::ofstream out(path);
+            out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+            bool first = true;
+            for (const auto &buffer : buffers) {
+                for (const Event &e : buffer->events) {
+                    out << (first ? "" : ",") << "\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1"
+                        << ",\"tid\":" << buffer->thread
+                        << ",\"ts\":" << static_cast<double>(e.begin - origin) / ticksPerMicro
+                        << ",\"dur\":" << static_cast<double>(e.end - e.begin) / ticksPerMicro << "}";
+                    first = false;
+                }
+            }
+            out << "\n]}\n";
+        }
+
+        void clear() {
+            std::lock_guard lock(mutex);
+            for (const auto &buffer : buffers) {
+                buffer->events.clear();
+            }
+        }
+    };
+
+    class Span {
+    private:
+        const char *name;
+        std::uint64_t begin;
+
+    public:
+        explicit Span(const char *name) : name(name), begin(now()) {}
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+        ~Span() {
+            Registry::instance().local().events.push_back({name, begin, now()});
+        }
+    };
+
+    inline void dump(const std::string &path) {
+        Registry::instance().dump(path);
+    }
+
+    inline void clear() {
+        Registry::instance().clear();
+    }
+
+}
+
+#define WORLDCUP_TRACE_CONCAT_IMPL(a, b) a##b
+#define WORLDCUP_TRACE_CONCAT(a, b) WORLDCUP_TRACE_CONCAT_IMPL(a, b)
+#define WORLDCUP_TRACE_SCOPE(name) ::trace::Span WORLDCUP_TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#else
+
+#define WORLDCUP_TRACE_SCOPE(name) static_cast<void>(0)
+
+#endif
+
+#endif